@@ -0,0 +1,121 @@
+#include <utils/imagecache.hpp>
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QTemporaryDir>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+constexpr int FileCount = 1000;
+
+// 原来的实现：路径、修改时间和大小拼成字符串后取 MD5 的十六进制
+auto md5CacheKey(const QFileInfo &fileInfo) -> QString
+{
+    if (!fileInfo.exists()) {
+        return {};
+    }
+    auto temp = QString("%1|%2|%3")
+                    .arg(fileInfo.absoluteFilePath(),
+                         QString::number(fileInfo.lastModified().toSecsSinceEpoch()),
+                         QString::number(fileInfo.size()));
+    return QCryptographicHash::hash(temp.toLocal8Bit(), QCryptographicHash::Md5).toHex();
+}
+
+// 模拟一个图片目录。stat 的结果已经缓存在 QFileInfo 里，只测量生成和查找键的开销
+class Files
+{
+public:
+    static auto instance() -> const Files &
+    {
+        static const Files files;
+        return files;
+    }
+
+    QList<QFileInfo> fileInfos;
+
+private:
+    Files()
+    {
+        for (int i = 0; i < FileCount; ++i) {
+            QFile file(m_dir.filePath(QString("image_%1.jpg").arg(i, 5, 10, QLatin1Char('0'))));
+            if (file.open(QIODevice::WriteOnly)) {
+                file.write(QByteArray(i % 64 + 1, 'x'));
+                file.close();
+            }
+            QFileInfo fileInfo(file.fileName());
+            fileInfo.size();
+            fileInfo.lastModified();
+            fileInfos.append(fileInfo);
+        }
+    }
+
+    QTemporaryDir m_dir;
+};
+
+void BM_Md5Key(benchmark::State &state)
+{
+    const auto &files = Files::instance();
+    for (auto _ : state) {
+        for (const auto &fileInfo : files.fileInfos) {
+            benchmark::DoNotOptimize(md5CacheKey(fileInfo));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * FileCount);
+}
+BENCHMARK(BM_Md5Key);
+
+void BM_CacheKey(benchmark::State &state)
+{
+    const auto &files = Files::instance();
+    for (auto _ : state) {
+        for (const auto &fileInfo : files.fileInfos) {
+            benchmark::DoNotOptimize(Utils::getCacheKey(fileInfo));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * FileCount);
+}
+BENCHMARK(BM_CacheKey);
+
+// 查找用的键单独生成一遍，不与表中的键共享数据
+void BM_Md5Lookup(benchmark::State &state)
+{
+    const auto &files = Files::instance();
+    QHash<QString, int> table;
+    QList<QString> keys;
+    for (int i = 0; i < FileCount; ++i) {
+        table.insert(md5CacheKey(files.fileInfos.at(i)), i);
+        keys.append(md5CacheKey(files.fileInfos.at(i)));
+    }
+    for (auto _ : state) {
+        for (const auto &key : std::as_const(keys)) {
+            benchmark::DoNotOptimize(table.constFind(key));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * FileCount);
+}
+BENCHMARK(BM_Md5Lookup);
+
+void BM_CacheKeyLookup(benchmark::State &state)
+{
+    const auto &files = Files::instance();
+    QHash<Utils::CacheKey, int> table;
+    QList<Utils::CacheKey> keys;
+    for (int i = 0; i < FileCount; ++i) {
+        table.insert(Utils::getCacheKey(files.fileInfos.at(i)), i);
+        keys.append(Utils::getCacheKey(files.fileInfos.at(i)));
+    }
+    for (auto _ : state) {
+        for (const auto &key : std::as_const(keys)) {
+            benchmark::DoNotOptimize(table.constFind(key));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * FileCount);
+}
+BENCHMARK(BM_CacheKeyLookup);
+
+} // namespace
@@ -0,0 +1,169 @@
+#include <graphics/graphicsarcitem.h>
+#include <graphics/graphicsringitem.h>
+
+#include <QApplication>
+#include <QPainterPath>
+#include <QPainterPathStroker>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+
+using namespace Graphics;
+
+namespace {
+
+// 拖动时每次移动都会改变几何，悬停检测随后取一次扩展后的形状
+const QPointF HoverPos(620, 500);
+
+// 原来的实现：每次几何变化后描边再与原路径合并
+auto strokeAndUnite(const QPainterPath &path, double expansion) -> QPainterPath
+{
+    QPainterPathStroker stroker;
+    stroker.setWidth(expansion);
+    return stroker.createStroke(path).united(path);
+}
+
+// 与 GeometryCache 的计算方式相同
+auto expansionOf(const GraphicsBasicItem &item) -> double
+{
+    return std::max({item.margin() * 0.5, static_cast<double>(item.pen().width()), 20.0});
+}
+
+auto rings() -> QList<Ring>
+{
+    return {{QPointF(500, 500), 100, 150}, {QPointF(500, 500), 101, 151}};
+}
+
+auto ringPath(const Ring &ring) -> QPainterPath
+{
+    QPainterPath path;
+    path.addEllipse(ring.boundingRect(0));
+    QPainterPath inner;
+    inner.addEllipse(ring.minBoundingRect(0));
+    return path - inner;
+}
+
+auto arcs() -> QList<Arc>
+{
+    return {{QPointF(500, 500), 100, 150, 30, 210}, {QPointF(500, 500), 101, 151, 31, 211}};
+}
+
+// 与 GraphicsArcItem 的路径形状相同的扇环
+auto arcPath(const Arc &arc) -> QPainterPath
+{
+    const QPointF outer(arc.maxRadius, arc.maxRadius);
+    const QPointF inner(arc.minRadius, arc.minRadius);
+    const QRectF outerRect(arc.center - outer, arc.center + outer);
+    const QRectF innerRect(arc.center - inner, arc.center + inner);
+    const auto sweep = arc.endAngle - arc.startAngle;
+    QPainterPath path;
+    path.arcMoveTo(outerRect, arc.startAngle);
+    path.arcTo(outerRect, arc.startAngle, sweep);
+    path.arcTo(innerRect, arc.endAngle, -sweep);
+    path.closeSubpath();
+    return path;
+}
+
+void BM_RingShapeStroker(benchmark::State &state)
+{
+    GraphicsRingItem item;
+    const auto shapes = rings();
+    const QList<QPainterPath> paths{ringPath(shapes.at(0)), ringPath(shapes.at(1))};
+    int i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(item.setRing(shapes.at(i)));
+        const auto shape = strokeAndUnite(paths.at(i), expansionOf(item));
+        benchmark::DoNotOptimize(shape.contains(HoverPos));
+        i ^= 1;
+    }
+}
+BENCHMARK(BM_RingShapeStroker);
+
+void BM_RingShapeExpander(benchmark::State &state)
+{
+    GraphicsRingItem item;
+    const auto shapes = rings();
+    int i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(item.setRing(shapes.at(i)));
+        benchmark::DoNotOptimize(item.shape().contains(HoverPos));
+        i ^= 1;
+    }
+}
+BENCHMARK(BM_RingShapeExpander);
+
+void BM_ArcShapeStroker(benchmark::State &state)
+{
+    GraphicsArcItem item;
+    const auto shapes = arcs();
+    const QList<QPainterPath> paths{arcPath(shapes.at(0)), arcPath(shapes.at(1))};
+    int i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(item.setArc(shapes.at(i)));
+        const auto shape = strokeAndUnite(paths.at(i), expansionOf(item));
+        benchmark::DoNotOptimize(shape.contains(HoverPos));
+        i ^= 1;
+    }
+}
+BENCHMARK(BM_ArcShapeStroker);
+
+void BM_ArcShapeExpander(benchmark::State &state)
+{
+    GraphicsArcItem item;
+    const auto shapes = arcs();
+    int i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(item.setArc(shapes.at(i)));
+        benchmark::DoNotOptimize(item.shape().contains(HoverPos));
+        i ^= 1;
+    }
+}
+BENCHMARK(BM_ArcShapeExpander);
+
+// 缩放来回切换时扩展长度在几个量化值之间变化。原来只缓存一个形状，每次都重新描边
+void BM_RingShapeZoomStroker(benchmark::State &state)
+{
+    const auto path = ringPath(rings().at(0));
+    const double expansions[] = {20, 24, 28, 24};
+    int i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(strokeAndUnite(path, expansions[i]).contains(HoverPos));
+        i = (i + 1) % 4;
+    }
+}
+BENCHMARK(BM_RingShapeZoomStroker);
+
+// 现在每个量化值缓存一个形状，只在第一次生成
+void BM_RingShapeZoom(benchmark::State &state)
+{
+    GraphicsRingItem item;
+    benchmark::DoNotOptimize(item.setRing(rings().at(0)));
+    const double margins[] = {40, 48, 56, 48};
+    int i = 0;
+    for (auto _ : state) {
+        item.setMargin(margins[i]);
+        benchmark::DoNotOptimize(item.shape().contains(HoverPos));
+        i = (i + 1) % 4;
+    }
+}
+BENCHMARK(BM_RingShapeZoom);
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    // 图元需要 QApplication，没有显示器时使用 offscreen 平台
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
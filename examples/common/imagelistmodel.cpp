@@ -1,17 +1,28 @@
 #include "imagelistmodel.h"
 
+#include <QResizeEvent>
 #include <QScrollBar>
+#include <QTimer>
 
 class ImageListModel::ImageListModelPrivate
 {
 public:
     explicit ImageListModelPrivate(ImageListModel *q)
         : q_ptr(q)
-    {}
+    {
+        flushTimer = new QTimer(q_ptr);
+        flushTimer->setSingleShot(true);
+        flushTimer->setInterval(BatchInterval);
+        QObject::connect(flushTimer, &QTimer::timeout, q_ptr, &ImageListModel::flush);
+    }
 
     ImageListModel *q_ptr;
 
     ThumbnailList datas;
+    // 与 datas 一一对应，第一次显示时才从 QImage 转换
+    QList<QPixmap> pixmaps;
+    ThumbnailList pendings;
+    QTimer *flushTimer;
 };
 
 ImageListModel::ImageListModel(QObject *parent)
@@ -32,9 +43,16 @@ auto ImageListModel::data(const QModelIndex &index, int role) const -> QVariant
         return {};
     }
 
-    auto data = d_ptr->datas.at(index.row());
+    const auto row = index.row();
+    auto data = d_ptr->datas.at(row);
     switch (role) {
-    case Qt::DecorationRole: return QPixmap::fromImage(data.image());
+    case Qt::DecorationRole: {
+        auto &pixmap = d_ptr->pixmaps[row];
+        if (pixmap.isNull()) {
+            pixmap = QPixmap::fromImage(data.image());
+        }
+        return pixmap;
+    }
     case Qt::WhatsThisRole:
     case Qt::ToolTipRole: return data.fileInfo().fileName();
     case Qt::SizeHintRole: return QSize(90, 90);
@@ -46,11 +64,50 @@ auto ImageListModel::data(const QModelIndex &index, int role) const -> QVariant
 
 void ImageListModel::setDatas(const ThumbnailList &datas)
 {
+    d_ptr->flushTimer->stop();
+    d_ptr->pendings.clear();
     beginResetModel();
     d_ptr->datas = datas;
+    d_ptr->pixmaps.clear();
+    d_ptr->pixmaps.resize(datas.size());
     endResetModel();
 }
 
+void ImageListModel::append(const Thumbnail &data)
+{
+    d_ptr->pendings.append(data);
+    if (d_ptr->pendings.size() >= BatchSize) {
+        flush();
+    } else if (!d_ptr->flushTimer->isActive()) {
+        d_ptr->flushTimer->start();
+    }
+}
+
+void ImageListModel::flush()
+{
+    d_ptr->flushTimer->stop();
+    if (d_ptr->pendings.isEmpty()) {
+        return;
+    }
+    const auto first = d_ptr->datas.size();
+    beginInsertRows({}, first, first + d_ptr->pendings.size() - 1);
+    d_ptr->datas.append(d_ptr->pendings);
+    d_ptr->pixmaps.resize(d_ptr->datas.size());
+    d_ptr->pendings.clear();
+    endInsertRows();
+}
+
+void ImageListModel::setImage(int row, const QImage &image)
+{
+    if (row < 0 || row >= d_ptr->datas.size()) {
+        return;
+    }
+    d_ptr->datas[row].setImage(image);
+    d_ptr->pixmaps[row] = QPixmap();
+    const auto modelIndex = index(row);
+    emit dataChanged(modelIndex, modelIndex, {Qt::DecorationRole});
+}
+
 class ImageListView::ImageListViewPrivate
 {
 public:
@@ -58,10 +115,19 @@ public:
         : q_ptr(q)
     {
         imageListModel = new ImageListModel(q_ptr);
+
+        rangeTimer = new QTimer(q_ptr);
+        rangeTimer->setSingleShot(true);
+        rangeTimer->setInterval(0);
     }
 
     ImageListView *q_ptr;
     ImageListModel *imageListModel;
+
+    // 合并同一轮事件循环中的多次滚动和布局变化
+    QTimer *rangeTimer;
+    int first = -1;
+    int last = -1;
 };
 
 ImageListView::ImageListView(QWidget *parent)
@@ -70,6 +136,14 @@ ImageListView::ImageListView(QWidget *parent)
 {
     setupUI();
     connect(this, &QListView::doubleClicked, this, &ImageListView::onChangedItem);
+
+    auto *timer = d_ptr->rangeTimer;
+    connect(timer, &QTimer::timeout, this, &ImageListView::updateVisibleRange);
+    auto startTimer = [timer] { timer->start(); };
+    connect(horizontalScrollBar(), &QScrollBar::valueChanged, timer, startTimer);
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, timer, startTimer);
+    connect(d_ptr->imageListModel, &QAbstractItemModel::modelReset, timer, startTimer);
+    connect(d_ptr->imageListModel, &QAbstractItemModel::rowsInserted, timer, startTimer);
 }
 
 ImageListView::~ImageListView() {}
@@ -79,11 +153,62 @@ void ImageListView::setDatas(const ThumbnailList &datas)
     d_ptr->imageListModel->setDatas(datas);
 }
 
+void ImageListView::appendData(const Thumbnail &data)
+{
+    d_ptr->imageListModel->append(data);
+}
+
+void ImageListView::setImage(int row, const QImage &image)
+{
+    d_ptr->imageListModel->setImage(row, image);
+}
+
 void ImageListView::onChangedItem(const QModelIndex &index)
 {
     emit changeItem(index.row());
 }
 
+void ImageListView::resizeEvent(QResizeEvent *event)
+{
+    QListView::resizeEvent(event);
+    d_ptr->rangeTimer->start();
+}
+
+void ImageListView::updateVisibleRange()
+{
+    const auto rowCount = d_ptr->imageListModel->rowCount();
+    const auto viewportRect = viewport()->rect();
+    const auto horizontal = flow() == LeftToRight;
+    // 列表项按顺序排成一行（或一列），二分查找与视口相交的首尾两项
+    auto lowerBound = [&](auto &&predicate) {
+        int low = 0;
+        int high = rowCount;
+        while (low < high) {
+            const auto middle = low + (high - low) / 2;
+            if (predicate(visualRect(d_ptr->imageListModel->index(middle)))) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return low;
+    };
+    const auto first = lowerBound([&](const QRect &rect) {
+        return horizontal ? rect.right() < viewportRect.left() : rect.bottom() < viewportRect.top();
+    });
+    const auto last = lowerBound([&](const QRect &rect) {
+                          return horizontal ? rect.left() <= viewportRect.right()
+                                            : rect.top() <= viewportRect.bottom();
+                      })
+                      - 1;
+    if (first == d_ptr->first && last == d_ptr->last) {
+        return;
+    }
+    d_ptr->first = first;
+    d_ptr->last = last;
+    emit visibleRangeChanged(first, last);
+}
+
 void ImageListView::setupUI()
 {
     setModel(d_ptr->imageListModel);
@@ -18,6 +18,13 @@ public:
         -> QVariant override;
 
     void setDatas(const ThumbnailList &datas);
+    // Rows are inserted in batches, either every BatchSize items or after BatchInterval ms.
+    void append(const Thumbnail &data);
+    void flush();
+    void setImage(int row, const QImage &image);
+
+    static constexpr int BatchSize = 64;
+    static constexpr int BatchInterval = 50;
 
 private:
     class ImageListModelPrivate;
@@ -32,15 +39,23 @@ public:
     ~ImageListView() override;
 
     void setDatas(const ThumbnailList &datas);
+    void appendData(const Thumbnail &data);
+    void setImage(int row, const QImage &image);
 
 signals:
     void changeItem(int);
+    // Emitted after scrolling, resizing or model changes settle, last is inclusive.
+    void visibleRangeChanged(int first, int last);
 
 private slots:
     void onChangedItem(const QModelIndex &index);
 
+protected:
+    void resizeEvent(QResizeEvent *event) override;
+
 private:
     void setupUI();
+    void updateVisibleRange();
 
     class ImageListViewPrivate;
     QScopedPointer<ImageListViewPrivate> d_ptr;
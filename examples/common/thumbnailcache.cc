@@ -1,91 +1,382 @@
 #include "thumbnailcache.hpp"
 #include "thumbnail.hpp"
 
-#include <utils/imagecache.hpp>
 #include <utils/utils.hpp>
 
 #include <QCache>
+#include <QDebug>
+#include <QDir>
 #include <QMutex>
+#include <QSaveFile>
+#include <QThreadPool>
+#include <QtMath>
 
-class ThumbnailCache::ThumbnailCachePrivate
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr quint32 recordMagic = 0x424d4854; // "THMB"
+constexpr quint32 indexMagic = 0x58444954;  // "TIDX"
+constexpr quint32 indexVersion = 1;
+
+// 数据文件由连续的记录组成，每条记录是 RecordHeader 加原始像素，按 8 字节对齐
+struct RecordHeader
+{
+    quint32 magic = recordMagic;
+    quint32 format = QImage::Format_Invalid;
+    Utils::CacheKey key;
+    qint32 width = 0;
+    qint32 height = 0;
+    qint32 bytesPerLine = 0;
+    quint32 dataSize = 0;
+};
+
+struct IndexHeader
+{
+    quint32 magic = indexMagic;
+    quint32 version = indexVersion;
+    qint64 dataEnd = 0;
+    quint64 tick = 0;
+    qint64 count = 0;
+};
+
+struct IndexEntry
+{
+    Utils::CacheKey key;
+    qint64 offset = 0;
+    quint64 lastAccess = 0;
+};
+
+static_assert(std::is_trivially_copyable_v<RecordHeader>);
+static_assert(std::is_trivially_copyable_v<IndexEntry>);
+
+inline auto recordSize(const RecordHeader &header) -> qint64
+{
+    return (static_cast<qint64>(sizeof(RecordHeader)) + header.dataSize + 7) & ~qint64(7);
+}
+
+// 写了一半或者索引与数据文件不一致时，头里的尺寸可能与像素数据对不上
+auto isValidRecord(const RecordHeader &header) -> bool
+{
+    if (header.magic != recordMagic || header.format <= QImage::Format_Invalid
+        || header.format >= QImage::NImageFormats || header.width <= 0 || header.height <= 0) {
+        return false;
+    }
+    const auto depth = QImage::toPixelFormat(static_cast<QImage::Format>(header.format))
+                           .bitsPerPixel();
+    const auto minBytesPerLine = (static_cast<qint64>(header.width) * depth + 7) / 8;
+    return header.bytesPerLine >= minBytesPerLine
+           && static_cast<qint64>(header.height) * header.bytesPerLine <= header.dataSize;
+}
+
+// 所有缩略图顺序追加到一个数据文件，索引常驻内存并在退出和压缩时写回。
+// 读取时直接从映射的内存拷贝像素，不需要解码。调用方负责加锁。
+class ThumbnailStore
 {
 public:
-    explicit ThumbnailCachePrivate(ThumbnailCache *q)
-        : q_ptr(q)
+    ThumbnailStore(const QString &path, qint64 maxBytes)
+        : m_dataFile(path + QStringLiteral(".dat"))
+        , m_indexPath(path + QStringLiteral(".idx"))
+        , m_maxBytes(maxBytes)
     {
-        thumbnailCache.setMaxCost(100 * 1024);
-        Utils::createDirectoryRecursively(cachePath);
-        QThreadPool::globalInstance()->start(std::bind(&ThumbnailCachePrivate::cleanCache, this));
+        if (!m_dataFile.open(QIODevice::ReadWrite)) {
+            qWarning() << "Failed to open thumbnail store:" << m_dataFile.errorString();
+            return;
+        }
+        loadIndex();
+        recover();
     }
 
-    void insert(const QString &key, const QImage &image)
+    ~ThumbnailStore()
     {
-        QMutexLocker locker(&mutex);
-        thumbnailCache.insert(key, new QImage(image), qMax(qCeil(image.sizeInBytes() / 1024.0), 1));
+        if (m_dirty) {
+            saveIndex();
+        }
     }
 
-    bool find(const QString &key, QImage &image)
+    bool find(const Utils::CacheKey &key, QImage &image)
     {
-        QMutexLocker locker(&mutex);
-        auto *imagePtr = thumbnailCache.object(key);
-        if (!imagePtr) {
+        auto it = m_index.find(key);
+        if (it == m_index.end()) {
             return false;
         }
-        image = *imagePtr;
-        return true;
+        RecordHeader header;
+        const auto offset = it->offset;
+        if (!readHeader(offset, header) || !(header.key == key) || !isValidRecord(header)
+            || offset + recordSize(header) > m_mappedSize) {
+            m_index.erase(it);
+            m_dirty = true;
+            return false;
+        }
+        const QImage view(m_mapped + offset + sizeof(RecordHeader),
+                          header.width,
+                          header.height,
+                          header.bytesPerLine,
+                          static_cast<QImage::Format>(header.format));
+        image = view.copy();
+        it->lastAccess = ++m_tick;
+        m_dirty = true;
+        return !image.isNull();
     }
 
-    void saveToDisk(const QString &key, const QImage &image)
+    void insert(const Utils::CacheKey &key, const QImage &image)
     {
-        const auto filePath(thumbnailCachePath(key));
-        if (QFile::exists(filePath)) {
+        if (!m_dataFile.isOpen() || m_index.contains(key)) {
             return;
         }
-        image.save(filePath, "png");
+        auto stored = image;
+        if (stored.colorCount() > 0) {
+            // 不保存调色板，转换成直接存储颜色的格式
+            stored.convertTo(stored.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied
+                                                      : QImage::Format_RGB32);
+        }
+
+        RecordHeader header;
+        header.format = stored.format();
+        header.key = key;
+        header.width = stored.width();
+        header.height = stored.height();
+        header.bytesPerLine = static_cast<qint32>(stored.bytesPerLine());
+        header.dataSize = static_cast<quint32>(stored.sizeInBytes());
+        const auto size = recordSize(header);
+        if (m_dataEnd + size > m_maxBytes) {
+            compact();
+            if (m_dataEnd + size > m_maxBytes) {
+                return;
+            }
+        }
+
+        const QByteArray padding(size - sizeof(RecordHeader) - header.dataSize, '\0');
+        m_dataFile.seek(m_dataEnd);
+        m_dataFile.write(reinterpret_cast<const char *>(&header), sizeof(RecordHeader));
+        m_dataFile.write(reinterpret_cast<const char *>(stored.constBits()), header.dataSize);
+        m_dataFile.write(padding);
+        m_dataFile.flush();
+
+        m_index.insert(key, {key, m_dataEnd, ++m_tick});
+        m_dataEnd += size;
+        m_dirty = true;
     }
 
-    bool loadFromDisk(const QString &key, QImage &image)
+private:
+    auto readHeader(qint64 offset, RecordHeader &header) -> bool
     {
-        const auto filePath(thumbnailCachePath(key));
-        if (!QFile::exists(filePath)) {
+        const auto end = offset + static_cast<qint64>(sizeof(RecordHeader));
+        if (end > m_dataEnd || (end > m_mappedSize && !remap())) {
             return false;
         }
-        image.load(filePath);
-        return !image.isNull();
+        std::memcpy(&header, m_mapped + offset, sizeof(RecordHeader));
+        return header.magic == recordMagic;
+    }
+
+    // 文件追加后映射的长度不够时重新映射
+    auto remap() -> bool
+    {
+        unmap();
+        if (m_dataEnd <= 0) {
+            return false;
+        }
+        m_mapped = m_dataFile.map(0, m_dataEnd);
+        if (!m_mapped) {
+            qWarning() << "Failed to map thumbnail store:" << m_dataFile.errorString();
+            return false;
+        }
+        m_mappedSize = m_dataEnd;
+        return true;
     }
 
-    QString thumbnailCachePath(const QString &key) const
+    void unmap()
     {
-        return QString("%1/%2").arg(cachePath, key);
+        if (m_mapped) {
+            m_dataFile.unmap(m_mapped);
+            m_mapped = nullptr;
+            m_mappedSize = 0;
+        }
+    }
+
+    void loadIndex()
+    {
+        QFile file(m_indexPath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return;
+        }
+        IndexHeader header;
+        if (file.read(reinterpret_cast<char *>(&header), sizeof(IndexHeader))
+                != sizeof(IndexHeader)
+            || header.magic != indexMagic || header.version != indexVersion
+            || header.dataEnd > m_dataFile.size() || header.count < 0
+            || header.count > file.size() / static_cast<qint64>(sizeof(IndexEntry))) {
+            return;
+        }
+        QList<IndexEntry> entries(header.count);
+        const auto bytes = static_cast<qint64>(header.count * sizeof(IndexEntry));
+        if (file.read(reinterpret_cast<char *>(entries.data()), bytes) != bytes) {
+            return;
+        }
+        m_index.reserve(entries.size());
+        for (const auto &entry : std::as_const(entries)) {
+            m_index.insert(entry.key, entry);
+        }
+        m_dataEnd = header.dataEnd;
+        m_tick = header.tick;
     }
 
-    void cleanCache()
+    // 上次退出前没有写回索引时，从索引记录的位置继续读取后面追加的记录
+    void recover()
     {
-        auto fileInfoList = QDir(cachePath).entryInfoList(QDir::Files | QDir::NoDotAndDotDot,
-                                                          QDir::Time);
-        const qint64 maxSize = 100 * 1024 * 1024;
-        qint64 totalSize = 0;
-        int index = -1;
-        for (int i = 0; i < fileInfoList.size(); ++i) {
-            totalSize += fileInfoList[i].size();
-            if (totalSize > maxSize) {
-                index = i;
+        const auto fileSize = m_dataFile.size();
+        auto offset = m_dataEnd;
+        while (offset + static_cast<qint64>(sizeof(RecordHeader)) <= fileSize) {
+            RecordHeader header;
+            m_dataFile.seek(offset);
+            if (m_dataFile.read(reinterpret_cast<char *>(&header), sizeof(RecordHeader))
+                    != sizeof(RecordHeader)
+                || !isValidRecord(header) || offset + recordSize(header) > fileSize) {
                 break;
             }
+            m_index.insert(header.key, {header.key, offset, ++m_tick});
+            offset += recordSize(header);
+        }
+        if (offset != fileSize) {
+            m_dataFile.resize(offset); // 丢弃写了一半的记录
+        }
+        if (offset != m_dataEnd) {
+            m_dataEnd = offset;
+            m_dirty = true;
         }
-        if (index == -1) {
+    }
+
+    void saveIndex()
+    {
+        QSaveFile file(m_indexPath);
+        if (!file.open(QIODevice::WriteOnly)) {
             return;
         }
-        for (int i = index; i < fileInfoList.size(); ++i) {
-            QFile::remove(fileInfoList[i].absoluteFilePath());
+        IndexHeader header;
+        header.dataEnd = m_dataEnd;
+        header.tick = m_tick;
+        header.count = m_index.size();
+        file.write(reinterpret_cast<const char *>(&header), sizeof(IndexHeader));
+        for (const auto &entry : std::as_const(m_index)) {
+            file.write(reinterpret_cast<const char *>(&entry), sizeof(IndexEntry));
+        }
+        if (file.commit()) {
+            m_dirty = false;
         }
     }
 
+    // 按最近访问时间保留记录，直到占满容量的 3/4
+    void compact()
+    {
+        if (!remap()) {
+            return;
+        }
+        auto entries = m_index.values();
+        std::sort(entries.begin(), entries.end(), [](const IndexEntry &lhs, const IndexEntry &rhs) {
+            return lhs.lastAccess > rhs.lastAccess;
+        });
+
+        QSaveFile file(m_dataFile.fileName());
+        if (!file.open(QIODevice::WriteOnly)) {
+            return;
+        }
+        QHash<Utils::CacheKey, IndexEntry> index;
+        qint64 end = 0;
+        for (const auto &entry : std::as_const(entries)) {
+            RecordHeader header;
+            if (!readHeader(entry.offset, header) || !isValidRecord(header)) {
+                continue;
+            }
+            const auto size = recordSize(header);
+            if (entry.offset + size > m_mappedSize) {
+                continue;
+            }
+            if (end + size > m_maxBytes / 4 * 3) {
+                break;
+            }
+            file.write(reinterpret_cast<const char *>(m_mapped + entry.offset), size);
+            index.insert(entry.key, {entry.key, end, entry.lastAccess});
+            end += size;
+        }
+
+        unmap();
+        m_dataFile.close();
+        if (file.commit()) {
+            m_index = index;
+            m_dataEnd = end;
+        }
+        if (!m_dataFile.open(QIODevice::ReadWrite)) {
+            qWarning() << "Failed to reopen thumbnail store:" << m_dataFile.errorString();
+        }
+        saveIndex();
+    }
+
+    QFile m_dataFile;
+    QString m_indexPath;
+    qint64 m_maxBytes;
+
+    uchar *m_mapped = nullptr;
+    qint64 m_mappedSize = 0;
+    qint64 m_dataEnd = 0;
+    quint64 m_tick = 0; // 逻辑时钟，用于 LRU
+    QHash<Utils::CacheKey, IndexEntry> m_index;
+    bool m_dirty = false;
+};
+
+} // namespace
+
+class ThumbnailCache::ThumbnailCachePrivate
+{
+public:
+    explicit ThumbnailCachePrivate(ThumbnailCache *q)
+        : q_ptr(q)
+    {
+        thumbnailCache.setMaxCost(100 * 1024);
+        // 旧版本每个缩略图保存一个 PNG 文件
+        const auto legacyPath = Utils::cachePath() + QStringLiteral("/thumbnails");
+        if (QFileInfo(legacyPath).isDir()) {
+            QThreadPool::globalInstance()->start(
+                [legacyPath] { QDir(legacyPath).removeRecursively(); });
+        }
+    }
+
+    void insert(const Utils::CacheKey &key, const QImage &image)
+    {
+        QMutexLocker locker(&mutex);
+        thumbnailCache.insert(key, new QImage(image), qMax(qCeil(image.sizeInBytes() / 1024.0), 1));
+    }
+
+    bool find(const Utils::CacheKey &key, QImage &image)
+    {
+        QMutexLocker locker(&mutex);
+        auto *imagePtr = thumbnailCache.object(key);
+        if (!imagePtr) {
+            return false;
+        }
+        image = *imagePtr;
+        return true;
+    }
+
+    void saveToDisk(const Utils::CacheKey &key, const QImage &image)
+    {
+        QMutexLocker locker(&storeMutex);
+        store.insert(key, image);
+    }
+
+    bool loadFromDisk(const Utils::CacheKey &key, QImage &image)
+    {
+        QMutexLocker locker(&storeMutex);
+        return store.find(key, image);
+    }
+
     ThumbnailCache *q_ptr;
 
-    QCache<QString, QImage> thumbnailCache;
+    QCache<Utils::CacheKey, QImage> thumbnailCache;
     QMutex mutex;
-    QString cachePath = Utils::cachePath() + QStringLiteral("/thumbnails");
+
+    QMutex storeMutex;
+    ThumbnailStore store{Utils::cachePath() + QStringLiteral("/thumbnails"), 256 * 1024 * 1024};
 };
 
 ThumbnailCache::ThumbnailCache(QObject *parent)
@@ -95,20 +386,21 @@ ThumbnailCache::ThumbnailCache(QObject *parent)
 
 ThumbnailCache::~ThumbnailCache() {}
 
-void ThumbnailCache::insert(const Thumbnail &thumbnail)
+void ThumbnailCache::insert(const Utils::CacheKey &key, const Thumbnail &thumbnail)
 {
     auto image = thumbnail.image();
-    if (image.isNull()) {
+    if (image.isNull() || !key.isValid()) {
         return;
     }
-    auto key = Utils::getCacheKey(thumbnail.fileInfo());
     d_ptr->insert(key, image);
     d_ptr->saveToDisk(key, image);
 }
 
-bool ThumbnailCache::find(Thumbnail &thumbnail)
+bool ThumbnailCache::find(const Utils::CacheKey &key, Thumbnail &thumbnail)
 {
-    auto key = Utils::getCacheKey(thumbnail.fileInfo());
+    if (!key.isValid()) {
+        return false;
+    }
     QImage image;
     if (d_ptr->find(key, image)) {
         thumbnail.setImage(image);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <utils/imagecache.hpp>
 #include <utils/singleton.hpp>
 
 #include <QObject>
@@ -9,8 +10,8 @@ class ThumbnailCache : public QObject
 {
     Q_OBJECT
 public:
-    void insert(const Thumbnail &thumbnail);
-    bool find(Thumbnail &thumbnail);
+    void insert(const Utils::CacheKey &key, const Thumbnail &thumbnail);
+    bool find(const Utils::CacheKey &key, Thumbnail &thumbnail);
 
 private:
     explicit ThumbnailCache(QObject *parent = nullptr);
@@ -6,8 +6,51 @@
 #include <QDir>
 #include <QPointer>
 #include <QThreadPool>
+#include <QtConcurrent>
 #include <QtWidgets>
 
+// 缩略图解码专用的线程池，不占用全局线程池
+Q_GLOBAL_STATIC(QThreadPool, thumbnailPool)
+
+static auto loadThumbnail(const QFileInfo &info) -> Thumbnail
+{
+    Thumbnail thumbnail;
+    thumbnail.setFileInfo(info);
+    auto *thumbnailCacheInstance = ThumbnailCache::instance();
+    const auto key = Utils::getCacheKey(info);
+    if (thumbnailCacheInstance->find(key, thumbnail)) {
+        return thumbnail;
+    }
+
+    // 直接按缩略图大小解码，JPEG 等格式不需要解出原图
+    QImageReader reader(info.absoluteFilePath());
+    reader.setAutoTransform(true);
+    const auto size = reader.size();
+    if (size.width() > WIDTH || size.height() > WIDTH) {
+        reader.setScaledSize(size.scaled(WIDTH, WIDTH, Qt::KeepAspectRatio));
+    }
+    auto image = reader.read();
+    if (image.isNull()) {
+        return thumbnail;
+    }
+    if (image.width() > WIDTH || image.height() > WIDTH) {
+        image = image.scaled(WIDTH, WIDTH, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+    thumbnail.setImage(image);
+    thumbnailCacheInstance->insert(key, thumbnail);
+    return thumbnail;
+}
+
+static auto imageSuffixes() -> QSet<QString>
+{
+    QSet<QString> suffixes;
+    const auto formats = QImageReader::supportedImageFormats();
+    for (const auto &format : formats) {
+        suffixes.insert(QString::fromLatin1(format).toLower());
+    }
+    return suffixes;
+}
+
 Viewer::Viewer(QWidget *parent)
     : QWidget(parent)
 {
@@ -19,13 +62,22 @@ Viewer::~Viewer()
     ImageLoadRunnable::terminateAll();
 }
 
-bool Viewer::setThumbnail(const Thumbnail &thumbnail, const qint64 taskCount)
+bool Viewer::setThumbnails(const ThumbnailList &thumbnails, const qint64 taskCount)
 {
     if (taskCount != (m_taskCount.load() - 1)) {
         return false;
     }
     QMetaObject::invokeMethod(
-        this, [this, thumbnail] { appendThumbnail(thumbnail); }, Qt::QueuedConnection);
+        this,
+        [this, thumbnails, taskCount] {
+            if (taskCount != (m_taskCount.load() - 1)) {
+                return;
+            }
+            m_thumbnailList = thumbnails;
+            m_imageListView->setDatas(m_thumbnailList);
+            m_thumbnailLoader->setThumbnails(m_thumbnailList);
+        },
+        Qt::QueuedConnection);
     return true;
 }
 
@@ -86,6 +138,12 @@ void Viewer::onJumpToMultiPage()
     emit jumpToMultiPage(m_urlLabel->text());
 }
 
+void Viewer::onThumbnailLoaded(int row, const QImage &image)
+{
+    // Thumbnail 是显式共享的，m_thumbnailList 中对应的项同时更新
+    m_imageListView->setImage(row, image);
+}
+
 QString Viewer::openImage()
 {
     const QString imageFilters(
@@ -104,7 +162,7 @@ void Viewer::startImageLoadThread(const QString &url)
 void Viewer::appendThumbnail(const Thumbnail &thumbnail)
 {
     m_thumbnailList.append(thumbnail);
-    m_imageListView->setDatas(m_thumbnailList);
+    m_imageListView->appendData(thumbnail);
 }
 
 void Viewer::clearThumbnail()
@@ -114,6 +172,7 @@ void Viewer::clearThumbnail()
     }
     m_thumbnailList.clear();
     m_imageListView->setDatas(m_thumbnailList);
+    m_thumbnailLoader->setThumbnails(m_thumbnailList);
 }
 
 void Viewer::setupUI()
@@ -136,6 +195,19 @@ void Viewer::setupUI()
     m_imageListView = new ImageListView(this);
     m_imageListView->setFixedHeight(120);
 
+    m_thumbnailLoader = new ThumbnailLoader(this);
+    connect(m_imageListView,
+            &ImageListView::visibleRangeChanged,
+            m_thumbnailLoader,
+            &ThumbnailLoader::setVisibleRange);
+    connect(m_thumbnailLoader,
+            &ThumbnailLoader::thumbnailLoaded,
+            this,
+            &Viewer::onThumbnailLoaded);
+    connect(m_thumbnailLoader, &ThumbnailLoader::thumbnailUnloaded, this, [this](int row) {
+        m_imageListView->setImage(row, {});
+    });
+
     auto *gridLayout = new QGridLayout(m_infoBox);
     gridLayout->addWidget(new QLabel(tr("Url: "), this), 0, 0, 1, 1);
     gridLayout->addWidget(m_urlLabel, 0, 1, 1, 1);
@@ -191,6 +263,7 @@ void ImageLoadRunnable::terminateAll()
     auto *instance = QThreadPool::globalInstance();
     instance->clear();
     instance->waitForDone();
+    thumbnailPool()->waitForDone();
 }
 
 void ImageLoadRunnable::run()
@@ -199,32 +272,140 @@ void ImageLoadRunnable::run()
     if (!file.exists()) {
         return;
     }
-    auto *thumbnailCacheInstance = ThumbnailCache::instance();
+
+    // 这里只根据目录列表生成占位项，解码由 ThumbnailLoader 按可见范围进行
+    const auto suffixes = imageSuffixes();
+    ThumbnailList thumbnails;
     QDirIterator it(file.absolutePath(), QDir::Files | QDir::NoDotAndDotDot);
     while (it.hasNext()) {
+        if (!ImageLoadRunnablePrivate::running.load(std::memory_order_acquire)) {
+            return;
+        }
         const QFileInfo info(it.next());
-        Thumbnail thumbnail;
-        thumbnail.setFileInfo(info);
-        auto find = thumbnailCacheInstance->find(thumbnail);
-        if (!find) {
-            QImage image(info.absoluteFilePath());
-            if (image.isNull()) {
-                continue;
-            }
-            thumbnail.setImage(image);
+        if (suffixes.contains(info.suffix().toLower())) {
+            thumbnails.append(Thumbnail(info, QImage()));
         }
-        auto image = thumbnail.image();
-        if (image.width() > WIDTH || image.height() > WIDTH) {
-            image = image.scaled(WIDTH, WIDTH, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-            thumbnail.setImage(image);
+    }
+    if (d_ptr->viewPtr.isNull()
+        || !ImageLoadRunnablePrivate::running.load(std::memory_order_acquire)) {
+        return;
+    }
+    d_ptr->viewPtr->setThumbnails(thumbnails, d_ptr->taskCount.load());
+}
+
+class ThumbnailLoader::ThumbnailLoaderPrivate
+{
+public:
+    enum class State : quint8 { Idle, Loading, Loaded };
+
+    explicit ThumbnailLoaderPrivate(ThumbnailLoader *q)
+        : q_ptr(q)
+    {}
+
+    // 从可见范围的中心向两侧查找下一个需要解码的行
+    [[nodiscard]] auto nextRow() const -> int
+    {
+        if (last < first) {
+            return -1;
         }
-        if (!find) {
-            thumbnailCacheInstance->insert(thumbnail);
+        const auto begin = qMax(first - PrefetchMargin, 0);
+        const auto end = qMin(last + PrefetchMargin, static_cast<int>(states.size()) - 1);
+        const auto center = first + (last - first) / 2;
+        for (int offset = 0; center - offset >= begin || center + offset <= end; ++offset) {
+            for (const auto row : {center - offset, center + offset}) {
+                if (row >= begin && row <= end && states.at(row) == State::Idle) {
+                    return row;
+                }
+            }
         }
-        if (d_ptr->viewPtr.isNull()
-            || !ImageLoadRunnablePrivate::running.load(std::memory_order_acquire)
-            || !d_ptr->viewPtr->setThumbnail(thumbnail, d_ptr->taskCount.load())) {
-            return;
+        return -1;
+    }
+
+    // 同时进行的解码不超过线程数，其余的留在队列里，滚动后重新排序
+    void schedule()
+    {
+        while (running < thumbnailPool()->maxThreadCount()) {
+            const auto row = nextRow();
+            if (row < 0) {
+                return;
+            }
+            states[row] = State::Loading;
+            ++running;
+            const auto currentSerial = serial;
+            QtConcurrent::run(thumbnailPool(), &loadThumbnail, thumbnails.at(row).fileInfo())
+                .then(q_ptr, [this, row, currentSerial](const Thumbnail &thumbnail) {
+                    if (currentSerial != serial) {
+                        return; // 已经切换了目录
+                    }
+                    --running;
+                    states[row] = State::Loaded;
+                    loadedRows.insert(row);
+                    emit q_ptr->thumbnailLoaded(row, thumbnail.image());
+                    schedule();
+                });
+        }
+    }
+
+    // 远离可见范围的行释放图像，滚动回来时再从缩略图缓存读取
+    void releaseFarRows()
+    {
+        const auto begin = first - KeepMargin;
+        const auto end = last + KeepMargin;
+        for (auto it = loadedRows.begin(); it != loadedRows.end();) {
+            const auto row = *it;
+            if (row >= begin && row <= end) {
+                ++it;
+                continue;
+            }
+            states[row] = State::Idle;
+            it = loadedRows.erase(it);
+            emit q_ptr->thumbnailUnloaded(row);
         }
     }
+
+    ThumbnailLoader *q_ptr;
+
+    ThumbnailList thumbnails;
+    QList<State> states;
+    QSet<int> loadedRows;
+    int first = 0;
+    int last = -1;
+    int running = 0;
+    quint64 serial = 0;
+};
+
+ThumbnailLoader::ThumbnailLoader(QObject *parent)
+    : QObject(parent)
+    , d_ptr(new ThumbnailLoaderPrivate(this))
+{}
+
+ThumbnailLoader::~ThumbnailLoader() = default;
+
+void ThumbnailLoader::setWorkerCount(int count)
+{
+    thumbnailPool()->setMaxThreadCount(count > 0 ? count : QThread::idealThreadCount());
+}
+
+auto ThumbnailLoader::workerCount() -> int
+{
+    return thumbnailPool()->maxThreadCount();
+}
+
+void ThumbnailLoader::setThumbnails(const ThumbnailList &thumbnails)
+{
+    ++d_ptr->serial;
+    d_ptr->running = 0;
+    d_ptr->thumbnails = thumbnails;
+    d_ptr->states = QList<ThumbnailLoaderPrivate::State>(thumbnails.size(),
+                                                         ThumbnailLoaderPrivate::State::Idle);
+    d_ptr->loadedRows.clear();
+    d_ptr->schedule();
+}
+
+void ThumbnailLoader::setVisibleRange(int first, int last)
+{
+    d_ptr->first = first;
+    d_ptr->last = last;
+    d_ptr->releaseFarRows();
+    d_ptr->schedule();
 }
@@ -7,6 +7,7 @@
 class QGroupBox;
 class QLabel;
 class QToolButton;
+class ThumbnailLoader;
 
 class Viewer : public QWidget
 {
@@ -15,7 +16,8 @@ public:
     explicit Viewer(QWidget *parent = nullptr);
     ~Viewer() override;
 
-    virtual auto setThumbnail(const Thumbnail &thumbnail, const qint64 taskCount) -> bool;
+    // Placeholders without images, thumbnails are decoded as their rows become visible.
+    virtual auto setThumbnails(const ThumbnailList &thumbnails, const qint64 taskCount) -> bool;
 
     void setEnableJumpToMultiPage(bool enable);
 
@@ -30,6 +32,7 @@ protected slots:
 
 private slots:
     void onJumpToMultiPage();
+    void onThumbnailLoaded(int row, const QImage &image);
 
 protected:
     QString openImage();
@@ -55,9 +58,40 @@ protected:
 private:
     void setupUI();
 
+    ThumbnailLoader *m_thumbnailLoader;
     bool m_enableJumpToMultiPage = false;
 };
 
+// Decodes the thumbnails of the rows around the visible range, nearest to its centre first.
+// Rows that scroll out of the prefetch window are dropped from the queue, rows further than
+// KeepMargin away release their images again.
+class ThumbnailLoader : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr int PrefetchMargin = 32;
+    static constexpr int KeepMargin = 512;
+
+    explicit ThumbnailLoader(QObject *parent = nullptr);
+    ~ThumbnailLoader() override;
+
+    // Thumbnails are decoded on a dedicated pool, count <= 0 resets to the ideal thread count.
+    static void setWorkerCount(int count);
+    static auto workerCount() -> int;
+
+    void setThumbnails(const ThumbnailList &thumbnails);
+    void setVisibleRange(int first, int last);
+
+signals:
+    // A null image means the file could not be decoded.
+    void thumbnailLoaded(int row, const QImage &image);
+    void thumbnailUnloaded(int row);
+
+private:
+    class ThumbnailLoaderPrivate;
+    QScopedPointer<ThumbnailLoaderPrivate> d_ptr;
+};
+
 class ImageLoadRunnable : public QRunnable
 {
 public:
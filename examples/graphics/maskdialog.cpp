@@ -155,7 +155,13 @@ void MaskDialog::onSave()
     if (filename.isEmpty()) {
         return;
     }
-    QImage mask = pixmapItem->maskImage();
+    // 遮罩只有覆盖率，按显示时的颜色着色后再叠加
+    QImage mask(pixmap.size(), QImage::Format_ARGB32_Premultiplied);
+    mask.fill(pixmapItem->maskColor());
+    QPainter maskPainter(&mask);
+    maskPainter.setCompositionMode(QPainter::CompositionMode_DestinationIn);
+    maskPainter.drawImage(0, 0, pixmapItem->maskImage());
+    maskPainter.end();
     QPainter painter(&pixmap);
     painter.setOpacity(d_ptr->opacitySpinBox->value());
     painter.drawImage(pixmap.rect(), mask);
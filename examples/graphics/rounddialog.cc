@@ -31,6 +31,7 @@ public:
         roundedRectItemPtr->setShowBoundingRect(true);
 
         imageView = new GraphicsView(q_ptr);
+        imageView->pixmapItem()->setMaskColor(Qt::black);
 
         previewLabel = new QLabel(q_ptr);
         previewLabel->setMinimumHeight(200);
@@ -84,8 +84,33 @@ public:
     {
         updateTransform();
         auto factor = transform.toTransform().m11() * windowSize.width()
-                      * q_ptr->devicePixelRatioF() / image.width();
+                      * q_ptr->devicePixelRatioF() / imageSize.width();
         emit q_ptr->scaleFactorChanged(factor);
+        loadFullResolutionIfNeeded(factor);
+    }
+
+    // 纹理的一个像素在屏幕上超过一个像素时换成更高分辨率的图像，但不超过最大纹理尺寸
+    void loadFullResolutionIfNeeded(qreal factor)
+    {
+        if (imageUrl.isEmpty() || fullResolutionRequested || image.size() == imageSize
+            || factor * imageSize.width() <= image.width()) {
+            return;
+        }
+
+        fullResolutionRequested = true;
+        const auto maxDimension = qMax(imageSize.width(), imageSize.height()) > maxTextureSize
+                                      ? maxTextureSize
+                                      : 0;
+        const auto serial = loadSerial;
+        Utils::ImageCache::instance()->findAsync(
+            imageUrl, maxDimension, q_ptr, [=, this](const QImage &source) {
+                if (serial != loadSerial || source.isNull()) {
+                    return;
+                }
+                image = source.convertedTo(QImage::Format_RGBA8888_Premultiplied);
+                uploadTexture();
+                q_ptr->update();
+            });
     }
 
     QSize rotatedTextureSize()
@@ -94,14 +119,14 @@ public:
         float theta = qDegreesToRadians(rotationAngle);
         float cosTheta = qAbs(qCos(theta));
         float sinTheta = qAbs(qSin(theta));
-        float rotatedWidth = image.width() * cosTheta + image.height() * sinTheta;
-        float rotatedHeight = image.width() * sinTheta + image.height() * cosTheta;
+        float rotatedWidth = imageSize.width() * cosTheta + imageSize.height() * sinTheta;
+        float rotatedHeight = imageSize.width() * sinTheta + imageSize.height() * cosTheta;
         return QSize(rotatedWidth, rotatedHeight);
     }
 
     void adjustImageToScreen()
     {
-        auto size = image.size();
+        auto size = imageSize;
         if (size.width() > q_ptr->width() || size.height() > q_ptr->height()) {
             q_ptr->fitToScreen();
         } else {
@@ -109,12 +134,33 @@ public:
         }
     }
 
+    void setImage(const QString &url, const QImage &source, const QSize &sourceSize)
+    {
+        imageUrl = url;
+        fullResolutionRequested = false;
+        image = source.convertedTo(QImage::Format_RGBA8888_Premultiplied);
+        imageSize = sourceSize.isValid() ? sourceSize : image.size();
+        scale = 1.0;
+        rotationAngle = 0;
+        adjustImageToScreen();
+
+        uploadTexture();
+
+        emit q_ptr->imageUrlChanged(url);
+        emit q_ptr->imageSizeChanged(imageSize);
+    }
+
     OpenglView *q_ptr;
 
     QScopedPointer<OpenGLShaderProgram> programPtr;
     GLuint texture;
 
+    // 纹理可能是降采样后的图像，几何计算统一使用原图尺寸
     QImage image;
+    QSize imageSize;
+    QString imageUrl;
+    bool fullResolutionRequested = false;
+    GLint maxTextureSize = 8192;
     QColor backgroundColor = Qt::white;
 
     QMatrix4x4 transform;
@@ -122,6 +168,7 @@ public:
     qreal scale = 1.0;
     int rotationAngle = 0;
     QSize windowSize;
+    quint64 loadSerial = 0;
 
     QMenu *menu;
 };
@@ -151,25 +198,30 @@ OpenglView::~OpenglView()
 
 void OpenglView::setImageUrl(const QString &imageUrl)
 {
-    QImage image;
+    const auto serial = ++d_ptr->loadSerial;
     if (imageUrl.isEmpty()) {
-        image = emptyImage();
-    } else if (!Utils::ImageCache::instance()->find(imageUrl, image)) {
-        QMessageBox::warning(this,
-                             tr("WARNING"),
-                             tr("Picture failed to open, Url: %1!").arg(imageUrl));
+        d_ptr->setImage(imageUrl, emptyImage(), {});
         return;
     }
 
-    d_ptr->image = image.convertedTo(QImage::Format_RGBA8888_Premultiplied);
-    d_ptr->scale = 1.0;
-    d_ptr->rotationAngle = 0;
-    d_ptr->adjustImageToScreen();
-
-    d_ptr->uploadTexture();
-
-    emit imageUrlChanged(imageUrl);
-    emit imageSizeChanged(d_ptr->image.size());
+    // 先按屏幕大小解码，放大时再加载原图
+    const auto imageSize = QImageReader(imageUrl).size();
+    const auto screenSize = screen()->size() * screen()->devicePixelRatio();
+    const auto maxDimension = qMin<int>(qMax(screenSize.width(), screenSize.height()),
+                                        d_ptr->maxTextureSize);
+    Utils::ImageCache::instance()->findAsync(
+        imageUrl, maxDimension, this, [=, this](const QImage &image) {
+            if (serial != d_ptr->loadSerial) {
+                return;
+            }
+            if (image.isNull()) {
+                QMessageBox::warning(this,
+                                     tr("WARNING"),
+                                     tr("Picture failed to open, Url: %1!").arg(imageUrl));
+                return;
+            }
+            d_ptr->setImage(imageUrl, image, imageSize);
+        });
 }
 
 void OpenglView::resetToOriginalSize()
@@ -232,6 +284,8 @@ void OpenglView::initializeGL()
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &d_ptr->maxTextureSize);
+
     d_ptr->programPtr.reset(new OpenGLShaderProgram(this));
     d_ptr->programPtr->addShaderFromSourceFile(QOpenGLShader::Vertex, ":/shader/texture.vert");
     d_ptr->programPtr->addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shader/texture.frag");
@@ -134,8 +134,57 @@ public:
     {
         updateTransform();
         auto factor = transform.toTransform().m11() * windowSize.width()
-                      * q_ptr->devicePixelRatioF() / image.width();
+                      * q_ptr->devicePixelRatioF() / imageSize.width();
         emit q_ptr->scaleFactorChanged(factor);
+        loadFullResolutionIfNeeded(factor);
+    }
+
+    auto maxTextureSize() const -> int
+    {
+        return rhi ? rhi->resourceLimit(QRhi::TextureSizeMax) : 8192;
+    }
+
+    // 纹理的一个像素在屏幕上超过一个像素时换成更高分辨率的图像，但不超过最大纹理尺寸
+    void loadFullResolutionIfNeeded(qreal factor)
+    {
+        if (imageUrl.isEmpty() || fullResolutionRequested || image.size() == imageSize
+            || factor * imageSize.width() <= image.width()) {
+            return;
+        }
+
+        fullResolutionRequested = true;
+        const auto maxDimension = qMax(imageSize.width(), imageSize.height()) > maxTextureSize()
+                                      ? maxTextureSize()
+                                      : 0;
+        const auto serial = loadSerial;
+        Utils::ImageCache::instance()->findAsync(
+            imageUrl, maxDimension, q_ptr, [=, this](const QImage &source) {
+                if (serial != loadSerial || source.isNull() || !scene.ps) {
+                    return;
+                }
+                image = source.convertToFormat(QImage::Format_RGBA8888);
+                initTexture();
+                q_ptr->update();
+            });
+    }
+
+    void setImage(const QString &url, const QImage &source, const QSize &sourceSize)
+    {
+        imageUrl = url;
+        fullResolutionRequested = false;
+        image = source.convertToFormat(QImage::Format_RGBA8888);
+        imageSize = sourceSize.isValid() ? sourceSize : image.size();
+        initTexture();
+
+        auto size = imageSize;
+        if (size.width() > q_ptr->width() || size.height() > q_ptr->height()) {
+            q_ptr->fitToScreen();
+        } else {
+            q_ptr->resetToOriginalSize();
+        }
+
+        emit q_ptr->imageUrlChanged(url);
+        emit q_ptr->imageSizeChanged(size);
     }
 
     RhiView *q_ptr;
@@ -157,12 +206,17 @@ public:
         QMatrix4x4 mvp;
     } scene;
 
+    // 纹理可能是降采样后的图像，几何计算统一使用原图尺寸
     QImage image;
+    QSize imageSize;
+    QString imageUrl;
+    bool fullResolutionRequested = false;
     QColor backgroundColor = Qt::white;
 
     QMatrix4x4 transform;
     const qreal scaleFactor = 1.2;
     QSize windowSize;
+    quint64 loadSerial = 0;
 
     QMenu *menu;
 };
@@ -180,28 +234,30 @@ RhiView::~RhiView() {}
 
 void RhiView::setImageUrl(const QString &imageUrl)
 {
-    QImage image;
+    const auto serial = ++d_ptr->loadSerial;
     if (imageUrl.isEmpty()) {
-        image = emptyImage();
-    } else if (!Utils::ImageCache::instance()->find(imageUrl, image)) {
-        QMessageBox::warning(this,
-                             tr("WARNING"),
-                             tr("Picture failed to open, Url: %1!").arg(imageUrl));
+        d_ptr->setImage(imageUrl, emptyImage(), {});
         return;
     }
 
-    d_ptr->image = image.convertToFormat(QImage::Format_RGBA8888);
-    d_ptr->initTexture();
-
-    auto size = d_ptr->image.size();
-    if (size.width() > width() || size.height() > height()) {
-        fitToScreen();
-    } else {
-        resetToOriginalSize();
-    }
-
-    emit imageUrlChanged(imageUrl);
-    emit imageSizeChanged(size);
+    // 先按屏幕大小解码，放大时再加载原图
+    const auto imageSize = QImageReader(imageUrl).size();
+    const auto screenSize = screen()->size() * screen()->devicePixelRatio();
+    const auto maxDimension = qMin(qMax(screenSize.width(), screenSize.height()),
+                                   d_ptr->maxTextureSize());
+    Utils::ImageCache::instance()->findAsync(
+        imageUrl, maxDimension, this, [=, this](const QImage &image) {
+            if (serial != d_ptr->loadSerial) {
+                return;
+            }
+            if (image.isNull()) {
+                QMessageBox::warning(this,
+                                     tr("WARNING"),
+                                     tr("Picture failed to open, Url: %1!").arg(imageUrl));
+                return;
+            }
+            d_ptr->setImage(imageUrl, image, imageSize);
+        });
 }
 
 void RhiView::resetToOriginalSize()
@@ -210,7 +266,7 @@ void RhiView::resetToOriginalSize()
         return;
     }
 
-    auto size = d_ptr->image.size();
+    auto size = d_ptr->imageSize;
     auto factor_w = static_cast<qreal>(size.width()) / width();
     auto factor_h = static_cast<qreal>(size.height()) / height();
     d_ptr->transform = d_ptr->rhi->clipSpaceCorrMatrix();
@@ -226,7 +282,7 @@ void RhiView::fitToScreen()
         return;
     }
 
-    auto size = d_ptr->image.size();
+    auto size = d_ptr->imageSize;
     auto factor_w = static_cast<qreal>(width()) / size.width();
     auto factor_h = static_cast<qreal>(height()) / size.height();
     auto factor = qMin(factor_w, factor_h);
@@ -0,0 +1,298 @@
+#include "animationplayer.hpp"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QImageReader>
+#include <QMutex>
+#include <QQueue>
+#include <QThread>
+#include <QTimer>
+#include <QWaitCondition>
+
+#include <atomic>
+
+namespace Graphics {
+
+namespace {
+
+struct Frame
+{
+    QImage image; // 为空表示动画结束
+    int number = 0;
+    int delay = 0;
+    double decodeMs = 0;
+};
+
+} // namespace
+
+class AnimationPlayer::AnimationPlayerPrivate
+{
+public:
+    explicit AnimationPlayerPrivate(AnimationPlayer *q)
+        : q_ptr(q)
+    {
+        timer = new QTimer(q_ptr);
+        timer->setSingleShot(true);
+        timer->setTimerType(Qt::PreciseTimer);
+    }
+
+    ~AnimationPlayerPrivate() { stopDecoder(); }
+
+    // 在解码线程执行，缓冲区满时等待播放端取走
+    auto push(Frame frame) -> bool
+    {
+        QMutexLocker locker(&mutex);
+        while (frames.size() >= bufferSize && !stopRequested.load(std::memory_order_relaxed)) {
+            notFull.wait(&mutex);
+        }
+        if (stopRequested.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        frames.enqueue(std::move(frame));
+        return true;
+    }
+
+    void decodeLoop()
+    {
+        QImageReader reader(fileName);
+        const auto loopCount = reader.loopCount();
+        QList<Frame> decodedFrames;
+        qint64 decodedBytes = 0;
+        bool keepDecoded = true;
+        int loop = 0;
+        int frameNumber = 0;
+
+        while (!stopRequested.load(std::memory_order_relaxed)) {
+            QElapsedTimer elapsed;
+            elapsed.start();
+            Frame frame;
+            frame.number = frameNumber++;
+            if (!reader.read(&frame.image)) {
+                if (loop == 0 && frame.number == 0) {
+                    qWarning() << "Failed to decode animation:" << reader.errorString();
+                }
+                break;
+            }
+            // 解码线程里转成绘制格式，播放时不再转换
+            frame.image.convertTo(frame.image.hasAlphaChannel()
+                                      ? QImage::Format_ARGB32_Premultiplied
+                                      : QImage::Format_RGB32);
+            frame.delay = qMax(reader.nextImageDelay(), MinimumDelay);
+            frame.decodeMs = elapsed.nsecsElapsed() / 1e6;
+
+            // 整个动画不大时只解码一次，后面的循环直接复用
+            if (keepDecoded) {
+                decodedBytes += frame.image.sizeInBytes();
+                if (decodedBytes <= DecodedBytesLimit) {
+                    decodedFrames.append(frame);
+                } else {
+                    keepDecoded = false;
+                    decodedFrames.clear();
+                }
+            }
+            if (!push(frame)) {
+                return;
+            }
+            if (reader.canRead()) {
+                continue;
+            }
+
+            // 只有一帧时不用循环
+            if (loop == 0 && frame.number == 0) {
+                break;
+            }
+            // 一轮结束，loopCount 小于 0 表示无限循环
+            ++loop;
+            if (loopCount >= 0 && loop > loopCount) {
+                break;
+            }
+            if (!keepDecoded) {
+                reader.setFileName(fileName);
+                frameNumber = 0;
+                continue;
+            }
+            while (!stopRequested.load(std::memory_order_relaxed)) {
+                for (const auto &decoded : std::as_const(decodedFrames)) {
+                    auto replay = decoded;
+                    replay.decodeMs = 0;
+                    if (!push(replay)) {
+                        return;
+                    }
+                }
+                if (loopCount >= 0 && ++loop > loopCount) {
+                    break;
+                }
+            }
+            break;
+        }
+        push({});
+    }
+
+    void startDecoder()
+    {
+        stopDecoder();
+        stopRequested.store(false, std::memory_order_relaxed);
+        decoder.reset(QThread::create([this] { decodeLoop(); }));
+        decoder->setObjectName(QStringLiteral("AnimationDecoder"));
+        decoder->start(QThread::LowPriority);
+    }
+
+    void stopDecoder()
+    {
+        timer->stop();
+        if (decoder.isNull()) {
+            return;
+        }
+        {
+            QMutexLocker locker(&mutex);
+            stopRequested.store(true, std::memory_order_relaxed);
+            notFull.wakeAll();
+        }
+        decoder->wait();
+        decoder.reset();
+        frames.clear();
+    }
+
+    void accumulate(const Frame &frame, double lateness)
+    {
+        ++statistics.framesShown;
+        const auto count = static_cast<double>(statistics.framesShown);
+        if (frame.decodeMs > 0) {
+            ++decodedCount;
+            statistics.averageDecodeMs += (frame.decodeMs - statistics.averageDecodeMs)
+                                          / decodedCount;
+        }
+        statistics.averageLatenessMs += (lateness - statistics.averageLatenessMs) / count;
+        statistics.maxLatenessMs = qMax(statistics.maxLatenessMs, lateness);
+    }
+
+    static constexpr int MinimumDelay = 10;
+    static constexpr qint64 DecodedBytesLimit = 64 * 1024 * 1024;
+
+    AnimationPlayer *q_ptr;
+
+    QString fileName;
+    int bufferSize = 8;
+
+    QMutex mutex;
+    QWaitCondition notFull;
+    QQueue<Frame> frames;
+    std::atomic_bool stopRequested = false;
+    QScopedPointer<QThread> decoder;
+
+    // 以下成员只在主线程访问
+    QTimer *timer;
+    QElapsedTimer clock;
+    qint64 nextDue = -1; // 下一帧应当显示的时间，相对 clock
+    qint64 decodedCount = 0;
+    bool waiting = false;
+    Statistics statistics;
+};
+
+AnimationPlayer::AnimationPlayer(QObject *parent)
+    : QObject(parent)
+    , d_ptr(new AnimationPlayerPrivate(this))
+{
+    connect(d_ptr->timer, &QTimer::timeout, this, &AnimationPlayer::showNextFrame);
+}
+
+AnimationPlayer::~AnimationPlayer() {}
+
+void AnimationPlayer::setFileName(const QString &fileName)
+{
+    stop();
+    d_ptr->fileName = fileName;
+}
+
+auto AnimationPlayer::fileName() const -> QString
+{
+    return d_ptr->fileName;
+}
+
+void AnimationPlayer::setBufferSize(int frames)
+{
+    QMutexLocker locker(&d_ptr->mutex);
+    d_ptr->bufferSize = qMax(frames, 1);
+    d_ptr->notFull.wakeAll();
+}
+
+auto AnimationPlayer::bufferSize() const -> int
+{
+    QMutexLocker locker(&d_ptr->mutex);
+    return d_ptr->bufferSize;
+}
+
+void AnimationPlayer::start()
+{
+    if (d_ptr->fileName.isEmpty()) {
+        return;
+    }
+    d_ptr->statistics = {};
+    d_ptr->decodedCount = 0;
+    d_ptr->nextDue = -1;
+    d_ptr->waiting = false;
+    d_ptr->clock.start();
+    d_ptr->startDecoder();
+    d_ptr->timer->start(0);
+}
+
+void AnimationPlayer::stop()
+{
+    d_ptr->stopDecoder();
+}
+
+auto AnimationPlayer::isRunning() const -> bool
+{
+    return !d_ptr->decoder.isNull();
+}
+
+auto AnimationPlayer::statistics() const -> Statistics
+{
+    return d_ptr->statistics;
+}
+
+void AnimationPlayer::showNextFrame()
+{
+    const auto now = d_ptr->clock.elapsed();
+    Frame frame;
+    {
+        QMutexLocker locker(&d_ptr->mutex);
+        if (d_ptr->frames.isEmpty()) {
+            // 解码跟不上，稍后再取
+            if (d_ptr->nextDue >= 0 && !d_ptr->waiting) {
+                ++d_ptr->statistics.underruns;
+            }
+            d_ptr->waiting = true;
+            d_ptr->timer->start(AnimationPlayerPrivate::MinimumDelay / 2);
+            return;
+        }
+        frame = d_ptr->frames.dequeue();
+        // 落后超过一帧时跳过已经过期的帧
+        while (d_ptr->nextDue >= 0 && !frame.image.isNull() && !d_ptr->frames.isEmpty()
+               && now - d_ptr->nextDue >= frame.delay
+               && !d_ptr->frames.head().image.isNull()) {
+            ++d_ptr->statistics.framesDropped;
+            d_ptr->nextDue += frame.delay;
+            frame = d_ptr->frames.dequeue();
+        }
+        d_ptr->notFull.wakeOne();
+    }
+    d_ptr->waiting = false;
+
+    if (frame.image.isNull()) {
+        d_ptr->stopDecoder();
+        emit finished();
+        return;
+    }
+
+    if (d_ptr->nextDue < 0) {
+        d_ptr->nextDue = now;
+    }
+    d_ptr->accumulate(frame, static_cast<double>(now - d_ptr->nextDue));
+    d_ptr->nextDue += frame.delay;
+    // 按计划时间而不是当前时间安排下一帧，误差不会累积
+    d_ptr->timer->start(static_cast<int>(qMax<qint64>(d_ptr->nextDue - now, 0)));
+    emit frameChanged(frame.image, frame.number);
+}
+
+} // namespace Graphics
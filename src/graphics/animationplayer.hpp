@@ -0,0 +1,54 @@
+#pragma once
+
+#include "graphics_global.h"
+
+#include <QImage>
+#include <QObject>
+
+namespace Graphics {
+
+// Plays an animated image at its native frame rate. Frames are decoded ahead on a
+// background thread into a small ring buffer; short animations are decoded only once
+// and replayed from memory.
+class GRAPHICS_EXPORT AnimationPlayer : public QObject
+{
+    Q_OBJECT
+public:
+    struct Statistics
+    {
+        qint64 framesShown = 0;
+        qint64 framesDropped = 0; // skipped to catch up after falling behind
+        qint64 underruns = 0;     // the next frame was due before it was decoded
+        double averageDecodeMs = 0;
+        double averageLatenessMs = 0;
+        double maxLatenessMs = 0;
+    };
+
+    explicit AnimationPlayer(QObject *parent = nullptr);
+    ~AnimationPlayer() override;
+
+    void setFileName(const QString &fileName);
+    [[nodiscard]] auto fileName() const -> QString;
+
+    // Number of decoded frames kept ahead of playback.
+    void setBufferSize(int frames);
+    [[nodiscard]] auto bufferSize() const -> int;
+
+    void start();
+    void stop();
+    [[nodiscard]] auto isRunning() const -> bool;
+
+    [[nodiscard]] auto statistics() const -> Statistics;
+
+signals:
+    void frameChanged(const QImage &frame, int frameNumber);
+    void finished();
+
+private:
+    void showNextFrame();
+
+    class AnimationPlayerPrivate;
+    QScopedPointer<AnimationPlayerPrivate> d_ptr;
+};
+
+} // namespace Graphics
@@ -0,0 +1,139 @@
+#include "annotationloader.hpp"
+#include "graphicspolygonitem.h"
+#include "graphicsrectitem.h"
+#include "graphicsutils.hpp"
+
+#include <QElapsedTimer>
+#include <QGraphicsScene>
+
+namespace Graphics {
+
+class AnnotationLoader::AnnotationLoaderPrivate
+{
+public:
+    explicit AnnotationLoaderPrivate(AnnotationLoader *q, QGraphicsScene *scene)
+        : q_ptr(q)
+        , scene(scene)
+    {}
+
+    // 先按场景范围筛掉越界的几何，返回通过的下标
+    template<typename Geometry, typename Points>
+    auto validate(const QList<Geometry> &geometries, Points points) -> QList<qsizetype>
+    {
+        const auto sceneRect = scene->sceneRect();
+        QList<qsizetype> accepted;
+        accepted.reserve(geometries.size());
+        for (qsizetype i = 0; i < geometries.size(); ++i) {
+            if (sceneRect.contains(Utils::createBoundingRect(points(geometries[i]), margin))) {
+                accepted.append(i);
+            }
+        }
+        return accepted;
+    }
+
+    template<typename Item, typename Geometry, typename Points, typename Setter>
+    auto load(const QList<Geometry> &geometries, Points points, Setter setter) -> GraphicsItemList
+    {
+        QElapsedTimer total;
+        total.start();
+        statistics = {};
+        statistics.requested = geometries.size();
+
+        QElapsedTimer elapsed;
+        elapsed.start();
+        const auto accepted = validate(geometries, points);
+        statistics.validateMs = elapsed.nsecsElapsed() / 1e6;
+
+        // 图元还不在场景中，设置几何时不会触发场景索引和重绘
+        elapsed.restart();
+        GraphicsItemList items(geometries.size(), nullptr);
+        GraphicsItemList loaded;
+        loaded.reserve(accepted.size());
+        for (const auto index : accepted) {
+            auto *item = new Item;
+            item->setMargin(margin);
+            item->setItemEditable(editable);
+            // 数量很大时逐个缓存设备坐标位图只会挤占 QPixmapCache
+            item->setCacheMode(QGraphicsItem::NoCache);
+            if (!setter(item, geometries[index])) {
+                delete item;
+                continue;
+            }
+            items[index] = item;
+            loaded.append(item);
+        }
+        statistics.buildMs = elapsed.nsecsElapsed() / 1e6;
+
+        // BSP 索引会把新加入的图元攒到下次查询时再统一插入
+        elapsed.restart();
+        for (auto *item : std::as_const(loaded)) {
+            scene->addItem(item);
+        }
+        statistics.insertMs = elapsed.nsecsElapsed() / 1e6;
+
+        statistics.loaded = loaded.size();
+        statistics.rejected = statistics.requested - statistics.loaded;
+        statistics.totalMs = total.nsecsElapsed() / 1e6;
+        return items;
+    }
+
+    AnnotationLoader *q_ptr;
+
+    QGraphicsScene *scene;
+    double margin = 6;
+    bool editable = true;
+    Statistics statistics;
+};
+
+AnnotationLoader::AnnotationLoader(QGraphicsScene *scene)
+    : d_ptr(new AnnotationLoaderPrivate(this, scene))
+{
+    Q_ASSERT(scene);
+}
+
+AnnotationLoader::~AnnotationLoader() {}
+
+void AnnotationLoader::setMargin(double margin)
+{
+    d_ptr->margin = margin;
+}
+
+auto AnnotationLoader::margin() const -> double
+{
+    return d_ptr->margin;
+}
+
+void AnnotationLoader::setItemEditable(bool editable)
+{
+    d_ptr->editable = editable;
+}
+
+auto AnnotationLoader::itemEditable() const -> bool
+{
+    return d_ptr->editable;
+}
+
+auto AnnotationLoader::loadRects(const QList<QRectF> &rects) -> GraphicsItemList
+{
+    return d_ptr->load<GraphicsRectItem>(
+        rects,
+        [](const QRectF &rect) { return QPolygonF{rect.topLeft(), rect.bottomRight()}; },
+        [](GraphicsRectItem *item, const QRectF &rect) { return item->setRect(rect); });
+}
+
+auto AnnotationLoader::loadPolygons(const QList<QPolygonF> &polygons) -> GraphicsItemList
+{
+    return d_ptr->load<GraphicsPolygonItem>(
+        polygons,
+        [](const QPolygonF &polygon) -> const QPolygonF & { return polygon; },
+        [](GraphicsPolygonItem *item, const QPolygonF &polygon) {
+            return item->setPolygon(polygon);
+        });
+}
+
+auto AnnotationLoader::statistics() const -> Statistics
+{
+    return d_ptr->statistics;
+}
+
+} // namespace Graphics
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "graphicsbasicitem.h"
+
+class QGraphicsScene;
+
+namespace Graphics {
+
+// Adds large label sets to a scene in one pass. Geometry is checked against the scene rect
+// up front and items are built before they join the scene, so setting their geometry
+// triggers no index updates or repaints.
+class GRAPHICS_EXPORT AnnotationLoader
+{
+public:
+    struct Statistics
+    {
+        qint64 requested = 0;
+        qint64 loaded = 0;
+        qint64 rejected = 0; // invalid or outside the scene rect
+        double validateMs = 0;
+        double buildMs = 0;
+        double insertMs = 0; // adding to the scene
+        double totalMs = 0;
+    };
+
+    explicit AnnotationLoader(QGraphicsScene *scene);
+    ~AnnotationLoader();
+
+    // Applied to every loaded item, see GraphicsBasicItem::setMargin().
+    void setMargin(double margin);
+    [[nodiscard]] auto margin() const -> double;
+
+    void setItemEditable(bool editable);
+    [[nodiscard]] auto itemEditable() const -> bool;
+
+    // The returned list matches the input order, rejected entries are null.
+    auto loadRects(const QList<QRectF> &rects) -> GraphicsItemList;
+    auto loadPolygons(const QList<QPolygonF> &polygons) -> GraphicsItemList;
+
+    // Timings of the last load.
+    [[nodiscard]] auto statistics() const -> Statistics;
+
+private:
+    class AnnotationLoaderPrivate;
+    QScopedPointer<AnnotationLoaderPrivate> d_ptr;
+};
+
+} // namespace Graphics
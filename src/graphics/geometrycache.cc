@@ -1 +1,87 @@
 #include "geometrycache.hpp"
+
+#include <cmath>
+
+namespace Graphics {
+
+int GeometryCache::anchorIndexAt(const QPointF &pos, double radius) const
+{
+    if (m_controlPoints.isEmpty() || radius < 0) {
+        return -1;
+    }
+    // 网格边长不小于查询半径，只需要检查相邻的 3x3 个格子
+    if (m_anchorCellSize <= 0 || m_anchorCellSize < radius) {
+        rebuildAnchorIndex(qMax(radius * 2, 1.0));
+    }
+
+    int index = -1;
+    const auto center = anchorCell(pos);
+    for (int y = center.y() - 1; y <= center.y() + 1; ++y) {
+        for (int x = center.x() - 1; x <= center.x() + 1; ++x) {
+            const auto it = m_anchorGrid.constFind(anchorCellKey({x, y}));
+            if (it == m_anchorGrid.cend()) {
+                continue;
+            }
+            for (const auto candidate : it.value()) {
+                if (index >= 0 && candidate > index) {
+                    continue;
+                }
+                const auto &point = m_controlPoints.at(candidate);
+                if (qAbs(point.x() - pos.x()) <= radius && qAbs(point.y() - pos.y()) <= radius) {
+                    index = candidate;
+                }
+            }
+        }
+    }
+    return index;
+}
+
+void GeometryCache::updateAnchorIndex(const QPolygonF &points)
+{
+    if (m_anchorCellSize <= 0) {
+        return;
+    }
+    if (points.size() != m_controlPoints.size()) {
+        m_anchorGrid.clear();
+        m_anchorCellSize = 0;
+        return;
+    }
+
+    for (int i = 0; i < points.size(); ++i) {
+        const auto oldCell = anchorCell(m_controlPoints.at(i));
+        const auto newCell = anchorCell(points.at(i));
+        if (oldCell == newCell) {
+            continue;
+        }
+        const auto oldKey = anchorCellKey(oldCell);
+        auto &oldIndexes = m_anchorGrid[oldKey];
+        oldIndexes.removeOne(i);
+        if (oldIndexes.isEmpty()) {
+            m_anchorGrid.remove(oldKey);
+        }
+        m_anchorGrid[anchorCellKey(newCell)].append(i);
+    }
+}
+
+void GeometryCache::rebuildAnchorIndex(double cellSize) const
+{
+    m_anchorGrid.clear();
+    m_anchorCellSize = cellSize;
+    for (int i = 0; i < m_controlPoints.size(); ++i) {
+        m_anchorGrid[anchorCellKey(anchorCell(m_controlPoints.at(i)))].append(i);
+    }
+}
+
+QPoint GeometryCache::anchorCell(const QPointF &point) const
+{
+    return {static_cast<int>(std::floor(point.x() / m_anchorCellSize)),
+            static_cast<int>(std::floor(point.y() / m_anchorCellSize))};
+}
+
+quint64 GeometryCache::anchorCellKey(const QPoint &cell)
+{
+    return (static_cast<quint64>(static_cast<quint32>(cell.x())) << 32)
+           | static_cast<quint32>(cell.y());
+}
+
+} // namespace Graphics
@@ -2,8 +2,12 @@
 
 #include "graphicsutils.hpp"
 
+#include <QCache>
+#include <QHash>
 #include <QPainterPath>
 
+#include <functional>
+
 namespace Graphics {
 
 class GeometryCache
@@ -13,50 +17,68 @@ public:
     GeometryCache() = default;
     ~GeometryCache() = default;
 
+    // 返回按 expansion 扩展后的形状。形状可以直接构造时由图元提供，
+    // 否则用描边合并路径计算
+    using ShapeExpander = std::function<QPainterPath(double expansion)>;
+
     void setControlPoints(const QPolygonF &points) { setGeometryData(points, {}, {}); }
 
-    void setGeometryData(const QPolygonF &points, const QRectF &bounds, const QPainterPath &path)
+    void setGeometryData(const QPolygonF &points,
+                         const QRectF &bounds,
+                         const QPainterPath &path,
+                         ShapeExpander expander = {})
     {
+        m_shapeExpander = std::move(expander);
         if (m_controlPoints == points && m_bounds == bounds && m_basePath == path) {
             return;
         }
 
+        updateAnchorIndex(points);
         m_controlPoints = points;
         m_bounds = bounds;
         m_basePath = path;
-        m_cacheDirty = true;
+        m_basePathBounds = path.controlPointRect();
+        m_expandedShapes.clear();
     }
 
-    QPolygonF controlPoints() const { return m_controlPoints; }
+    const QPolygonF &controlPoints() const { return m_controlPoints; }
+
+    // 返回以锚点为中心、边长为 2 * radius 的正方形包含 pos 的锚点下标，
+    // 有多个时返回最小的下标，没有时返回 -1
+    int anchorIndexAt(const QPointF &pos, double radius) const;
 
-    QRectF visualBoundingRect(double margin, double penWidth, double expandAmount)
+    // 描边的尖角最多超出路径一个描边宽度（默认斜接限制为 2），边界矩形直接计算，
+    // 场景索引频繁查询时不需要生成扩展后的路径
+    QRectF visualBoundingRect(double margin, double penWidth, double expandAmount) const
     {
-        updateCacheIfNeeded(margin, penWidth, expandAmount);
-        return m_cachedBounds;
+        const double offset = calculateTotalExpansion(margin, penWidth, expandAmount);
+        return m_basePathBounds.adjusted(-offset, -offset, offset, offset);
     }
 
     QPainterPath visualShape(double margin, double penWidth, double expandAmount)
     {
-        updateCacheIfNeeded(margin, penWidth, expandAmount);
-        return m_cachedPath;
+        const double expansion = calculateTotalExpansion(margin, penWidth, expandAmount);
+        const int key = qRound(expansion * ExpansionSteps);
+        if (const auto *shape = m_expandedShapes.object(key)) {
+            return *shape;
+        }
+        const double quantized = static_cast<double>(key) / ExpansionSteps;
+        auto *shape = new QPainterPath(m_shapeExpander
+                                           ? m_shapeExpander(quantized)
+                                           : Utils::expandAndUnitePath(m_basePath, quantized));
+        const auto result = *shape;
+        m_expandedShapes.insert(key, shape);
+        return result;
     }
 
     bool hasValidGeometry() const { return !m_bounds.isNull() && !m_controlPoints.isEmpty(); }
 
 private:
-    void updateCacheIfNeeded(double margin, double penWidth, double expandAmount)
-    {
-        const double expansion = calculateTotalExpansion(margin, penWidth, expandAmount);
-        if (!m_cacheDirty && qFuzzyCompare(m_cachedExpansion, expansion)) {
-            return; // 缓存仍然有效
-        }
-
-        m_cacheDirty = false;
-        m_cachedExpansion = expansion;
-        m_cachedPath = m_basePath;
-        m_cachedPath = Utils::expandAndUnitePath(m_cachedPath, expansion);
-        m_cachedBounds = m_cachedPath.controlPointRect();
-    }
+    // 锚点按均匀网格索引，移动锚点时只更新变化的点，数量变化时下次查询再重建
+    void updateAnchorIndex(const QPolygonF &points);
+    void rebuildAnchorIndex(double cellSize) const;
+    QPoint anchorCell(const QPointF &point) const;
+    static quint64 anchorCellKey(const QPoint &cell);
 
     static double calculateTotalExpansion(double margin, double penWidth, double expandAmount)
     {
@@ -67,10 +89,14 @@ private:
     QRectF m_bounds;           // 边界矩形
     QPainterPath m_basePath;   // 路径
 
-    bool m_cacheDirty = true;     // 路径是否需要重新计算
-    double m_cachedExpansion = 0; // 路径扩展长度
-    QPainterPath m_cachedPath;    // 缓存路径
-    QRectF m_cachedBounds;        // 缓存矩形
+    // 扩展长度按 1/ExpansionSteps 量化，每个量化值缓存一个形状，最近使用的优先保留
+    static constexpr int ExpansionSteps = 4;
+    QRectF m_basePathBounds;                        // 路径的控制点矩形
+    ShapeExpander m_shapeExpander;                  // 直接构造扩展形状
+    QCache<int, QPainterPath> m_expandedShapes{4}; // 扩展后的形状
+
+    mutable QHash<quint64, QList<int>> m_anchorGrid; // 网格到锚点下标
+    mutable double m_anchorCellSize = 0;             // 为 0 时需要重建
 };
 
 using GeometryCachePtr = QScopedPointer<GeometryCache>;
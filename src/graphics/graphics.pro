@@ -1,6 +1,6 @@
 include(../../qmake/PlatformLibraries.pri)
 
-QT += widgets concurrent
+QT += widgets concurrent openglwidgets
 
 DEFINES += GRAPHICS_LIBRARY
 TARGET = $$add_platform_library(graphics)
@@ -8,6 +8,8 @@ TARGET = $$add_platform_library(graphics)
 LIBS += -l$$replaceLibName(utils)
 
 SOURCES += \
+    animationplayer.cc \
+    annotationloader.cc \
     geometrycache.cc \
     graphicsarcitem.cpp \
     graphicsbasicitem.cpp \
@@ -19,11 +21,16 @@ SOURCES += \
     graphicsringitem.cpp \
     graphicsrotatedrectitem.cpp \
     graphicsroundedrectitem.cc \
+    graphicsshapelayer.cc \
     graphicstextitem.cc \
+    graphicstiledimageitem.cc \
     graphicsutils.cc \
-    graphicsview.cc
+    graphicsview.cc \
+    tiledimage.cc
 
 HEADERS += \
+    animationplayer.hpp \
+    annotationloader.hpp \
     geometrycache.hpp \
     graphics_global.h \
     graphicsarcitem.h \
@@ -36,6 +43,9 @@ HEADERS += \
     graphicsringitem.h \
     graphicsrotatedrectitem.h \
     graphicsroundedrectitem.hpp \
+    graphicsshapelayer.hpp \
     graphicstextitem.hpp \
+    graphicstiledimageitem.hpp \
     graphicsutils.hpp \
-    graphicsview.hpp
+    graphicsview.hpp \
+    tiledimage.hpp
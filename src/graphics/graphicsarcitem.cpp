@@ -62,6 +62,33 @@ auto calculateFinalArc(const QPolygonF &ply) -> Arc
                endAngle};
 }
 
+// 扇环扩展后，内外弧半径各变化 half，两条边各向外平移 half，直接构造；
+// 内弧收缩为点或扩展后超过整圆时退回描边
+auto expandArc(const Arc &arc, const QPainterPath &path, double expansion) -> QPainterPath
+{
+    const double half = expansion / 2;
+    const double outer = arc.maxRadius + half;
+    const double inner = arc.minRadius - half;
+    const double sweep = arc.endAngle - arc.startAngle;
+    if (inner <= half || outer <= half) {
+        return Utils::expandAndUnitePath(path, expansion);
+    }
+    const double outerDelta = qRadiansToDegrees(qAsin(half / outer));
+    const double innerDelta = qRadiansToDegrees(qAsin(half / inner));
+    if (sweep + 2 * innerDelta >= 360) {
+        return Utils::expandAndUnitePath(path, expansion);
+    }
+
+    const QRectF outerRect(arc.center.x() - outer, arc.center.y() - outer, outer * 2, outer * 2);
+    const QRectF innerRect(arc.center.x() - inner, arc.center.y() - inner, inner * 2, inner * 2);
+    QPainterPath expanded;
+    expanded.arcMoveTo(outerRect, arc.startAngle - outerDelta);
+    expanded.arcTo(outerRect, arc.startAngle - outerDelta, sweep + 2 * outerDelta);
+    expanded.arcTo(innerRect, arc.endAngle + innerDelta, -(sweep + 2 * innerDelta));
+    expanded.closeSubpath();
+    return expanded;
+}
+
 } // namespace
 
 auto Arc::isValid(double margin) const -> bool
@@ -126,11 +153,10 @@ auto GraphicsArcItem::setArc(const Arc &arc) -> bool
         return false;
     }
 
-    auto sceneRect = scene()->sceneRect();
     QPolygonF pts = d_ptr->arcPath.toFillPolygon() + anchorPoints;
     double addLen = margin() * qSqrt(2) / 2;
     auto rect = pts.boundingRect().adjusted(-addLen, -addLen, addLen, addLen);
-    if (!sceneRect.contains(rect)) {
+    if (scene() && !scene()->sceneRect().contains(rect)) {
         return false;
     }
 
@@ -138,7 +164,11 @@ auto GraphicsArcItem::setArc(const Arc &arc) -> bool
     d_ptr->arch = arc;
     geometryCache()->setGeometryData(anchorPoints,
                                      Utils::createBoundingRect(pts, 0),
-                                     d_ptr->arcPath);
+                                     d_ptr->arcPath,
+                                     [arc, path = d_ptr->arcPath](double expansion) {
+                                         return expandArc(arc, path, expansion);
+                                     });
+    emit geometryChanged();
 
     return true;
 }
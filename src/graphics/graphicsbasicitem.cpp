@@ -57,11 +57,13 @@ auto GraphicsBasicItem::isValid() const -> bool
 
 auto GraphicsBasicItem::boundingRect() const -> QRectF
 {
-    return d_ptr->geometryCachePtr->hasValidGeometry()
-               ? d_ptr->geometryCachePtr->visualBoundingRect(margin(),
-                                                             pen().width(),
-                                                             d_ptr->minExpandSize)
-               : scene()->sceneRect();
+    if (d_ptr->geometryCachePtr->hasValidGeometry()) {
+        return d_ptr->geometryCachePtr->visualBoundingRect(margin(),
+                                                           pen().width(),
+                                                           d_ptr->minExpandSize);
+    }
+    // 创建中的图元覆盖整个场景以接收鼠标事件，还不在场景中时为空
+    return scene() ? scene()->sceneRect() : QRectF();
 }
 
 auto GraphicsBasicItem::shape() const -> QPainterPath
@@ -182,20 +184,12 @@ void GraphicsBasicItem::hoverMoveEvent(QGraphicsSceneHoverEvent *event)
 
     d_ptr->mouseRegin = MouseRegion::NoSelection;
     d_ptr->hoveredDotIndex = -1;
-    const auto &anchorPoints = d_ptr->geometryCachePtr->controlPoints();
-    const qreal halfMargin = d_ptr->margin * 0.5;
-    const QPointF marginOffset(halfMargin, halfMargin);
-
-    for (int i = 0; i < anchorPoints.size(); ++i) {
-        const auto &point = anchorPoints.at(i);
-        const QRectF area(point - marginOffset, point + marginOffset);
-
-        if (area.contains(scenePos)) {
-            d_ptr->hoveredDotIndex = i;
-            d_ptr->mouseRegin = MouseRegion::AnchorPoint;
-            setCursor(Qt::PointingHandCursor);
-            return;
-        }
+    const auto index = d_ptr->geometryCachePtr->anchorIndexAt(scenePos, d_ptr->margin * 0.5);
+    if (index >= 0) {
+        d_ptr->hoveredDotIndex = index;
+        d_ptr->mouseRegin = MouseRegion::AnchorPoint;
+        setCursor(Qt::PointingHandCursor);
+        return;
     }
 
     if (detectEdgeRegion(scenePos) == MouseRegion::EdgeArea) {
@@ -270,8 +264,8 @@ void GraphicsBasicItem::drawAnchor(QPainter *painter)
         return;
     }
 
-    auto anchorPoints = d_ptr->geometryCachePtr->controlPoints();
-    for (const QPointF &p : std::as_const(anchorPoints)) {
+    const auto &anchorPoints = d_ptr->geometryCachePtr->controlPoints();
+    for (const QPointF &p : anchorPoints) {
         painter->fillRect(QRectF(p.x() - d_ptr->margin / 2,
                                  p.y() - d_ptr->margin / 2,
                                  d_ptr->margin,
@@ -41,6 +41,10 @@ public:
     void setShowBoundingRect(bool show);
     bool showBoundingRect() const;
 
+signals:
+    // Emitted after a shape setter accepted new geometry.
+    void geometryChanged();
+
 protected:
     void mousePressEvent(QGraphicsSceneMouseEvent *event) override;
     void mouseMoveEvent(QGraphicsSceneMouseEvent *event) override;
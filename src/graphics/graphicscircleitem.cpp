@@ -66,7 +66,7 @@ auto GraphicsCircleItem::setCircle(const Circle &circle) -> bool
     }
 
     auto rect = circle.boundingRect(margin());
-    if (!scene()->sceneRect().contains(rect)) {
+    if (scene() && !scene()->sceneRect().contains(rect)) {
         return false;
     }
     rect = circle.boundingRect(0);
@@ -77,6 +77,7 @@ auto GraphicsCircleItem::setCircle(const Circle &circle) -> bool
     prepareGeometryChange();
     d_ptr->circle = circle;
     geometryCache()->setGeometryData(d_ptr->circle.controlPoints(), rect, shape);
+    emit geometryChanged();
 
     return true;
 }
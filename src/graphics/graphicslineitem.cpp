@@ -89,11 +89,13 @@ auto GraphicsLineItem::setLine(const QLineF &line) -> bool
 
     QPolygonF anchorPoints{line.p1(), line.p2()};
     auto rect = Utils::createBoundingRect(anchorPoints, margin());
-    auto sceneRect = scene()->sceneRect();
-    if (rect.isValid() && !sceneRect.contains(rect)) {
-        return false;
-    } else if (!sceneRect.contains(line.p1()) || !sceneRect.contains(line.p2())) {
-        return false;
+    if (scene()) {
+        auto sceneRect = scene()->sceneRect();
+        if (rect.isValid() && !sceneRect.contains(rect)) {
+            return false;
+        } else if (!sceneRect.contains(line.p1()) || !sceneRect.contains(line.p2())) {
+            return false;
+        }
     }
 
     prepareGeometryChange();
@@ -102,6 +104,7 @@ auto GraphicsLineItem::setLine(const QLineF &line) -> bool
                                      Utils::createBoundingRect(anchorPoints, 0),
                                      lineShape(d_ptr->line, 6));
     emit lineChanged(line);
+    emit geometryChanged();
 
     return true;
 }
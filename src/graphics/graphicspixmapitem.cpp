@@ -1,75 +1,123 @@
 #include "graphicspixmapitem.h"
 
+#include <QCache>
 #include <QCursor>
 #include <QDebug>
 #include <QGraphicsSceneMouseEvent>
+#include <QKeyEvent>
 #include <QPainter>
 #include <QStyleOptionGraphicsItem>
+#include <QTimer>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 namespace Graphics {
 
 namespace {
 
+struct CursorKey
+{
+    int mode = 0;
+    int brushSize = 0;
+    int scaleStep = 0;
+};
+
+inline bool operator==(const CursorKey &lhs, const CursorKey &rhs) noexcept
+{
+    return lhs.mode == rhs.mode && lhs.brushSize == rhs.brushSize
+           && lhs.scaleStep == rhs.scaleStep;
+}
+
+inline size_t qHash(const CursorKey &key, size_t seed = 0) noexcept
+{
+    return qHashMulti(seed, key.mode, key.brushSize, key.scaleStep);
+}
+
+// 光标按画笔大小和量化后的缩放比例缓存，缩放时只在跨过量化级别时切换
 class CursorManager
 {
 public:
-    CursorManager() = default;
+    // 每倍缩放分成的级别数，光标大小误差不超过约 2%
+    static constexpr int ScaleStepsPerOctave = 16;
 
-    void updateScaleFactor(const QPainter *painter);
-    QCursor createCursorForMode(GraphicsPixmapItem::MaskEditingMode mode);
+    CursorManager() { m_cursors.setMaxCost(64); }
+
+    // 返回 true 表示量化后的缩放比例变化，需要切换光标
+    bool updateScaleFactor(const QPainter *painter);
+    QCursor cursorForMode(GraphicsPixmapItem::MaskEditingMode mode);
 
     // 配置方法
     void setBrushSize(int size) { m_brushSize = qBound(1, size, 500); }
     int brushSize() const { return m_brushSize; }
 
-    void setCheckerColor1(const QColor &color) { m_checkerColor1 = color; }
+    void setCheckerColor1(const QColor &color)
+    {
+        m_checkerColor1 = color;
+        m_cursors.clear();
+    }
     QColor checkerColor1() const { return m_checkerColor1; }
 
-    void setCheckerColor2(const QColor &color) { m_checkerColor2 = color; }
+    void setCheckerColor2(const QColor &color)
+    {
+        m_checkerColor2 = color;
+        m_cursors.clear();
+    }
     QColor checkerColor2() const { return m_checkerColor2; }
 
-    void setOutlineColor(const QColor &color) { m_outlineColor = color; }
+    void setOutlineColor(const QColor &color)
+    {
+        m_outlineColor = color;
+        m_cursors.clear();
+    }
     QColor outlineColor() const { return m_outlineColor; }
 
-    double viewScaleFactor() const { return m_viewScaleFactor; }
-    bool needsUpdate() const { return m_needsUpdate; }
-    void setNeedsUpdate(bool needsUpdate) { m_needsUpdate = needsUpdate; }
-
-    QPixmap currentBrushPattern() const { return m_currentBrushPattern; }
-    void setCurrentBrushPattern(const QPixmap &pattern) { m_currentBrushPattern = pattern; }
+    double viewScaleFactor() const { return std::exp2(double(m_scaleStep) / ScaleStepsPerOctave); }
 
 private:
     QPixmap createCheckerboardPattern(int size) const;
     QPixmap createCursorPixmap(const QPixmap &brushPattern) const;
 
     int m_brushSize = 50;
-    double m_viewScaleFactor = 1.0;
+    int m_scaleStep = 0;
     QColor m_checkerColor1 = QColor(220, 220, 220);
     QColor m_checkerColor2 = Qt::white;
     QColor m_outlineColor = QColor(220, 220, 220);
-    bool m_needsUpdate = true;
-    QPixmap m_currentBrushPattern;
+    QCache<CursorKey, QCursor> m_cursors;
 };
 
-void CursorManager::updateScaleFactor(const QPainter *painter)
+bool CursorManager::updateScaleFactor(const QPainter *painter)
 {
     if (!painter) {
-        return;
+        return false;
     }
 
-    const double newScaleFactor = painter->transform().m11();
-    if (qAbs(newScaleFactor - m_viewScaleFactor) > 0.01) {
-        m_viewScaleFactor = newScaleFactor;
-        m_needsUpdate = true;
+    const auto scale = QStyleOptionGraphicsItem::levelOfDetailFromTransform(
+        painter->worldTransform());
+    if (scale <= 0.0) {
+        return false;
+    }
+    const auto step = qRound(std::log2(scale) * ScaleStepsPerOctave);
+    if (step == m_scaleStep) {
+        return false;
     }
+    m_scaleStep = step;
+    return true;
 }
 
-QCursor CursorManager::createCursorForMode(GraphicsPixmapItem::MaskEditingMode mode)
+QCursor CursorManager::cursorForMode(GraphicsPixmapItem::MaskEditingMode mode)
 {
     if (mode == GraphicsPixmapItem::MaskEditingMode::Normal) {
         return QCursor();
     }
 
+    const CursorKey key{static_cast<int>(mode), m_brushSize, m_scaleStep};
+    if (const auto *cursor = m_cursors.object(key)) {
+        return *cursor;
+    }
+
     QPixmap brushPattern;
     if (mode == GraphicsPixmapItem::MaskEditingMode::Erase) {
         brushPattern = QPixmap(m_brushSize, m_brushSize);
@@ -78,9 +126,10 @@ QCursor CursorManager::createCursorForMode(GraphicsPixmapItem::MaskEditingMode m
         brushPattern = createCheckerboardPattern(m_brushSize);
     }
 
-    m_currentBrushPattern = brushPattern;
-
-    return QCursor(createCursorPixmap(brushPattern));
+    auto *cursor = new QCursor(createCursorPixmap(brushPattern));
+    const auto result = *cursor;
+    m_cursors.insert(key, cursor);
+    return result;
 }
 
 QPixmap CursorManager::createCheckerboardPattern(int size) const
@@ -102,7 +151,7 @@ QPixmap CursorManager::createCheckerboardPattern(int size) const
 
 QPixmap CursorManager::createCursorPixmap(const QPixmap &brushPattern) const
 {
-    const int scaledSize = m_brushSize * m_viewScaleFactor;
+    const int scaledSize = qMax(1, qRound(m_brushSize * viewScaleFactor()));
     auto brush = brushPattern.scaled(scaledSize,
                                      scaledSize,
                                      Qt::KeepAspectRatio,
@@ -122,20 +171,72 @@ QPixmap CursorManager::createCursorPixmap(const QPixmap &brushPattern) const
     return cursorPixmap;
 }
 
+// 一次笔画修改前后的 tile 内容，压缩保存，空数组表示全透明
+struct TileDelta
+{
+    int index = 0;
+    QByteArray before;
+    QByteArray after;
+};
+
+struct MaskEdit
+{
+    QList<TileDelta> tiles;
+    qint64 bytes = 0;
+};
+
+// 遮罩按 tile 保存为 Alpha8，笔画只修改经过的 tile，全透明的 tile 不分配内存。
+// 绘制时按遮罩颜色和透明度着色，着色结果缓存到 tile 再次修改为止
+bool isTransparent(const QImage &alpha)
+{
+    for (int y = 0; y < alpha.height(); ++y) {
+        const auto *line = alpha.constScanLine(y);
+        if (std::any_of(line, line + alpha.width(), [](uchar value) { return value != 0; })) {
+            return false;
+        }
+    }
+    return true;
+}
+
 class MaskPainter
 {
 public:
+    static constexpr int TileSize = 256;
+
     MaskPainter() = default;
 
     void reset(const QSize &size);
-    bool isValid() const { return !m_maskImage.isNull(); }
+    bool isValid() const { return !m_size.isEmpty(); }
+    QSize size() const { return m_size; }
+
+    // 拼接成完整的 Alpha8 遮罩图像
+    QImage maskImage() const;
+    void setMaskImage(const QImage &image);
 
-    // 访问器方法
-    const QImage &maskImage() const { return m_maskImage; }
-    void setMaskImage(const QImage &image) { m_maskImage = image; }
+    // 直接在经过的 tile 上绘制线段，返回受影响的区域
+    QRect drawLine(const QPointF &from, const QPointF &to, const QPen &pen, bool erase);
+    void paint(QPainter *painter, const QRectF &exposedRect);
+
+    // 记录一次笔画经过的 tile 修改前的内容，结束时生成撤销用的差异
+    void beginStroke();
+    MaskEdit endStroke();
+    bool isRecording() const { return m_recording; }
+    // 恢复差异中 tile 修改前或修改后的内容，返回受影响的区域
+    QRect applyEdit(const MaskEdit &edit, bool undo);
 
     double opacity() const { return m_opacity; }
-    void setOpacity(double opacity) { m_opacity = qBound(0.0, opacity, 1.0); }
+    void setOpacity(double opacity)
+    {
+        m_opacity = qBound(0.0, opacity, 1.0);
+        m_tintedTiles.clear();
+    }
+
+    const QColor &color() const { return m_color; }
+    void setColor(const QColor &color)
+    {
+        m_color = color;
+        m_tintedTiles.clear();
+    }
 
     const QPointF &lastBrushPosition() const { return m_lastBrushPosition; }
     void setLastBrushPosition(const QPointF &position) { m_lastBrushPosition = position; }
@@ -144,20 +245,327 @@ public:
     void setCurrentBrushPosition(const QPointF &position) { m_currentBrushPosition = position; }
 
 private:
-    QImage m_maskImage;
+    QRect tileRect(int column, int row) const;
+    // 区域覆盖的 tile 行列范围
+    QRect tileRange(const QRect &rect) const;
+    QByteArray compressTile(const QImage &tile) const;
+    QImage uncompressTile(const QByteArray &data, const QRect &rect) const;
+    const QImage *tintedTile(int index);
+
+    QSize m_size;
+    int m_columns = 0;
+    QList<QImage> m_tiles; // 按行存储，空图像表示全透明
+    bool m_recording = false;
+    QHash<int, QImage> m_strokeTiles; // 隐式共享，修改 tile 时才分离出副本
+    QCache<int, QImage> m_tintedTiles; // 已经乘上颜色和透明度，直接绘制
     double m_opacity = 0.5;
+    QColor m_color = QColor(220, 220, 220);
     QPointF m_lastBrushPosition;
     QPointF m_currentBrushPosition;
 };
 
 void MaskPainter::reset(const QSize &size)
 {
-    m_maskImage = QImage(size, QImage::Format_ARGB32_Premultiplied);
-    m_maskImage.fill(Qt::transparent);
+    m_size = size;
+    m_columns = (size.width() + TileSize - 1) / TileSize;
+    const int rows = (size.height() + TileSize - 1) / TileSize;
+    m_tiles = QList<QImage>(static_cast<qsizetype>(m_columns) * rows);
+    m_recording = false;
+    m_strokeTiles.clear();
+    m_tintedTiles.clear();
+    // 按 tile 数量确定上限，整张遮罩都被覆盖时也能全部缓存，缩小显示时不会反复着色
+    m_tintedTiles.setMaxCost(m_tiles.size() * TileSize * TileSize * 4);
     m_lastBrushPosition = QPointF();
     m_currentBrushPosition = QPointF();
 }
 
+QImage MaskPainter::maskImage() const
+{
+    if (!isValid()) {
+        return {};
+    }
+    QImage image(m_size, QImage::Format_Alpha8);
+    image.fill(0);
+    for (qsizetype i = 0; i < m_tiles.size(); ++i) {
+        const auto &tile = m_tiles.at(i);
+        if (tile.isNull()) {
+            continue;
+        }
+        const auto rect = tileRect(i % m_columns, i / m_columns);
+        for (int y = 0; y < rect.height(); ++y) {
+            std::memcpy(image.scanLine(rect.y() + y) + rect.x(),
+                        tile.constScanLine(y),
+                        rect.width());
+        }
+    }
+    return image;
+}
+
+void MaskPainter::setMaskImage(const QImage &image)
+{
+    reset(image.size());
+    QImage source;
+    if (image.format() == QImage::Format_Grayscale8) {
+        // 灰度值直接作为覆盖率
+        source = image;
+        source.reinterpretAsFormat(QImage::Format_Alpha8);
+    } else {
+        source = image.convertToFormat(QImage::Format_Alpha8);
+    }
+    for (qsizetype i = 0; i < m_tiles.size(); ++i) {
+        auto tile = source.copy(tileRect(i % m_columns, i / m_columns));
+        if (!isTransparent(tile)) {
+            m_tiles[i] = tile;
+        }
+    }
+}
+
+QRect MaskPainter::drawLine(const QPointF &from, const QPointF &to, const QPen &pen, bool erase)
+{
+    const auto margin = pen.widthF() / 2 + 2;
+    const auto dirty = QRectF(from, to)
+                           .normalized()
+                           .adjusted(-margin, -margin, margin, margin)
+                           .toAlignedRect()
+                       & QRect(QPoint(0, 0), m_size);
+    if (dirty.isEmpty()) {
+        return {};
+    }
+
+    const auto range = tileRange(dirty);
+    for (int row = range.top(); row <= range.bottom(); ++row) {
+        for (int column = range.left(); column <= range.right(); ++column) {
+            const auto index = row * m_columns + column;
+            auto &tile = m_tiles[index];
+            const auto rect = tileRect(column, row);
+            if (tile.isNull() && erase) {
+                continue;
+            }
+            if (m_recording && !m_strokeTiles.contains(index)) {
+                m_strokeTiles.insert(index, tile);
+            }
+            if (tile.isNull()) {
+                tile = QImage(rect.size(), QImage::Format_Alpha8);
+                tile.fill(0);
+            }
+            m_tintedTiles.remove(index);
+            QPainter painter(&tile);
+            painter.translate(-rect.topLeft());
+            if (erase) {
+                painter.setCompositionMode(QPainter::CompositionMode_Clear);
+            }
+            painter.setPen(pen);
+            painter.drawLine(from, to);
+        }
+    }
+    return dirty;
+}
+
+void MaskPainter::paint(QPainter *painter, const QRectF &exposedRect)
+{
+    const auto rect = exposedRect.toAlignedRect() & QRect(QPoint(0, 0), m_size);
+    if (rect.isEmpty()) {
+        return;
+    }
+    const auto range = tileRange(rect);
+    for (int row = range.top(); row <= range.bottom(); ++row) {
+        for (int column = range.left(); column <= range.right(); ++column) {
+            if (const auto *tinted = tintedTile(row * m_columns + column)) {
+                painter->drawImage(tileRect(column, row).topLeft(), *tinted);
+            }
+        }
+    }
+}
+
+void MaskPainter::beginStroke()
+{
+    m_recording = true;
+    m_strokeTiles.clear();
+}
+
+MaskEdit MaskPainter::endStroke()
+{
+    MaskEdit edit;
+    for (auto it = m_strokeTiles.cbegin(); it != m_strokeTiles.cend(); ++it) {
+        TileDelta delta{it.key(), compressTile(it.value()), compressTile(m_tiles.at(it.key()))};
+        edit.bytes += delta.before.size() + delta.after.size() + sizeof(TileDelta);
+        edit.tiles.append(delta);
+    }
+    m_recording = false;
+    m_strokeTiles.clear();
+    return edit;
+}
+
+QRect MaskPainter::applyEdit(const MaskEdit &edit, bool undo)
+{
+    QRect dirty;
+    for (const auto &delta : std::as_const(edit.tiles)) {
+        if (delta.index < 0 || delta.index >= m_tiles.size()) {
+            continue;
+        }
+        const auto rect = tileRect(delta.index % m_columns, delta.index / m_columns);
+        m_tiles[delta.index] = uncompressTile(undo ? delta.before : delta.after, rect);
+        m_tintedTiles.remove(delta.index);
+        dirty |= rect;
+    }
+    return dirty;
+}
+
+QByteArray MaskPainter::compressTile(const QImage &tile) const
+{
+    if (tile.isNull()) {
+        return {};
+    }
+    // 遮罩大片相同，最快的压缩级别就足够
+    return qCompress(tile.constBits(), static_cast<int>(tile.sizeInBytes()), 1);
+}
+
+QImage MaskPainter::uncompressTile(const QByteArray &data, const QRect &rect) const
+{
+    if (data.isEmpty()) {
+        return {};
+    }
+    const auto raw = qUncompress(data);
+    QImage tile(rect.size(), QImage::Format_Alpha8);
+    if (raw.size() != tile.sizeInBytes()) {
+        qWarning() << "Corrupted mask history tile";
+        tile.fill(0);
+        return tile;
+    }
+    std::memcpy(tile.bits(), raw.constData(), raw.size());
+    return tile;
+}
+
+const QImage *MaskPainter::tintedTile(int index)
+{
+    const auto &tile = m_tiles.at(index);
+    if (tile.isNull()) {
+        return nullptr;
+    }
+    if (const auto *tinted = m_tintedTiles.object(index)) {
+        return tinted;
+    }
+    auto color = m_color;
+    color.setAlphaF(color.alphaF() * m_opacity);
+    auto *tinted = new QImage(tile.size(), QImage::Format_ARGB32_Premultiplied);
+    tinted->fill(color);
+    {
+        QPainter painter(tinted);
+        painter.setCompositionMode(QPainter::CompositionMode_DestinationIn);
+        painter.drawImage(0, 0, tile);
+    }
+    const auto cost = tinted->sizeInBytes();
+    m_tintedTiles.insert(index, tinted, cost);
+    return m_tintedTiles.object(index);
+}
+
+// 撤销和重做栈，超过内存上限时先丢弃最早的记录
+class MaskHistory
+{
+public:
+    void push(const MaskEdit &edit);
+    bool canUndo() const { return !m_undoEdits.isEmpty(); }
+    bool canRedo() const { return !m_redoEdits.isEmpty(); }
+    MaskEdit undo();
+    MaskEdit redo();
+    void clear();
+
+    void setMemoryLimit(qint64 bytes);
+    qint64 memoryLimit() const { return m_memoryLimit; }
+
+private:
+    void trim();
+
+    QList<MaskEdit> m_undoEdits;
+    QList<MaskEdit> m_redoEdits;
+    qint64 m_bytes = 0;
+    qint64 m_memoryLimit = 64 * 1024 * 1024;
+};
+
+void MaskHistory::push(const MaskEdit &edit)
+{
+    for (const auto &redoEdit : std::as_const(m_redoEdits)) {
+        m_bytes -= redoEdit.bytes;
+    }
+    m_redoEdits.clear();
+    m_undoEdits.append(edit);
+    m_bytes += edit.bytes;
+    trim();
+}
+
+MaskEdit MaskHistory::undo()
+{
+    auto edit = m_undoEdits.takeLast();
+    m_redoEdits.append(edit);
+    return edit;
+}
+
+MaskEdit MaskHistory::redo()
+{
+    auto edit = m_redoEdits.takeLast();
+    m_undoEdits.append(edit);
+    return edit;
+}
+
+void MaskHistory::clear()
+{
+    m_undoEdits.clear();
+    m_redoEdits.clear();
+    m_bytes = 0;
+}
+
+void MaskHistory::setMemoryLimit(qint64 bytes)
+{
+    m_memoryLimit = qMax<qint64>(bytes, 0);
+    trim();
+}
+
+void MaskHistory::trim()
+{
+    while (m_bytes > m_memoryLimit && !m_undoEdits.isEmpty()) {
+        m_bytes -= m_undoEdits.takeFirst().bytes;
+    }
+    while (m_bytes > m_memoryLimit && !m_redoEdits.isEmpty()) {
+        m_bytes -= m_redoEdits.takeFirst().bytes;
+    }
+}
+
+QRect MaskPainter::tileRect(int column, int row) const
+{
+    return QRect(column * TileSize, row * TileSize, TileSize, TileSize)
+        .intersected(QRect(QPoint(0, 0), m_size));
+}
+
+QRect MaskPainter::tileRange(const QRect &rect) const
+{
+    return QRect(QPoint(rect.left() / TileSize, rect.top() / TileSize),
+                 QPoint(rect.right() / TileSize, rect.bottom() / TileSize));
+}
+
+// 边长小于这个值的图像直接绘制原图
+constexpr int mipMinimumSize = 1024;
+// 最粗一层的边长
+constexpr int mipSmallestSize = 256;
+// 图像保持不变这么久（毫秒）之后才生成 mipmap
+constexpr int mipStableInterval = 300;
+
+// 在线程池中逐级减半，每一层从上一层缩放
+auto createMipLevels(const QImage &source) -> QList<QImage>
+{
+    QList<QImage> levels;
+    auto image = source;
+    while (qMax(image.width(), image.height()) > mipSmallestSize) {
+        image = image.scaled((image.width() + 1) / 2,
+                             (image.height() + 1) / 2,
+                             Qt::IgnoreAspectRatio,
+                             Qt::SmoothTransformation);
+        image.convertTo(image.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied
+                                                : QImage::Format_RGB32);
+        levels.append(image);
+    }
+    return levels;
+}
+
 } // anonymous namespace
 
 // 私有实现类
@@ -166,13 +574,91 @@ class GraphicsPixmapItem::GraphicsPixmapItemPrivate
 public:
     explicit GraphicsPixmapItemPrivate(GraphicsPixmapItem *q)
         : q_ptr(q)
-    {}
+    {
+        // 缩放后在绘制结束后再切换光标，不在 paint 中生成
+        cursorTimer.setSingleShot(true);
+        cursorTimer.setInterval(0);
+        QObject::connect(&cursorTimer, &QTimer::timeout, &cursorTimer, [this] {
+            q_ptr->updateCursor();
+        });
+
+        mipTimer.setSingleShot(true);
+        mipTimer.setInterval(mipStableInterval);
+        QObject::connect(&mipTimer, &QTimer::timeout, &mipTimer, [this] {
+            const auto pixmap = q_ptr->pixmap();
+            if (pixmap.cacheKey() == mipPendingKey) {
+                buildMipLevels(pixmap);
+            }
+        });
+    }
+
+    // 返回绘制用的层级，0 为原图，第 n 层的边长约为原图的 1/2^n。
+    // 选择不小于显示比例的最粗一层，还没有生成时先画原图，图像稳定后再在后台生成
+    auto mipLevel(qreal scale) -> int
+    {
+        if (scale <= 0.0 || scale > 0.5) {
+            return 0;
+        }
+        const auto pixmap = q_ptr->pixmap();
+        if (qMax(pixmap.width(), pixmap.height()) < mipMinimumSize) {
+            return 0;
+        }
+        if (pixmap.cacheKey() != mipSourceKey) {
+            mipLevels.clear();
+            mipSourceKey = 0;
+        }
+        if (mipLevels.isEmpty()) {
+            // 动画每帧都会更换图像，等图像一段时间不变再生成，避免每帧都白白生成一次
+            if (pixmap.cacheKey() != mipPendingKey) {
+                mipPendingKey = pixmap.cacheKey();
+                mipTimer.start();
+            }
+            return 0;
+        }
+        const auto level = static_cast<int>(std::floor(std::log2(1.0 / scale)));
+        return qBound(0, level, static_cast<int>(mipLevels.size()));
+    }
+
+    void buildMipLevels(const QPixmap &pixmap)
+    {
+        const auto key = pixmap.cacheKey();
+        if (mipBuildingKey == key) {
+            return;
+        }
+        mipBuildingKey = key;
+        // 光栅后端的 QPixmap 内部就是 QImage，转换也放到线程池中，不占用 GUI 线程
+        QtConcurrent::run([pixmap] { return createMipLevels(pixmap.toImage()); })
+            .then(&mipContext, [this, key](const QList<QImage> &levels) {
+                if (mipBuildingKey == key) {
+                    mipBuildingKey = 0;
+                }
+                if (key != q_ptr->pixmap().cacheKey()) {
+                    return; // 图像已经更换
+                }
+                mipLevels.clear();
+                for (const auto &level : levels) {
+                    mipLevels.append(QPixmap::fromImage(level));
+                }
+                mipSourceKey = key;
+                q_ptr->update();
+            });
+    }
 
     GraphicsPixmapItem *q_ptr;
 
+    QList<QPixmap> mipLevels; // 第 1 层开始
+    qint64 mipSourceKey = 0;
+    qint64 mipBuildingKey = 0;
+    qint64 mipPendingKey = 0;
+    QTimer mipTimer;
+    QObject mipContext; // 析构后不再处理未完成的结果
+
     CursorManager cursorManager;
+    QTimer cursorTimer;
     MaskPainter maskPainter;
+    MaskHistory maskHistory;
     GraphicsPixmapItem::MaskEditingMode editingMode = GraphicsPixmapItem::MaskEditingMode::Normal;
+    bool editingEnabled = true;
 };
 
 GraphicsPixmapItem::GraphicsPixmapItem(QGraphicsItem *parent)
@@ -180,7 +666,7 @@ GraphicsPixmapItem::GraphicsPixmapItem(QGraphicsItem *parent)
     , d_ptr(new GraphicsPixmapItemPrivate(this))
 {
     setAcceptHoverEvents(true);
-    setFlags(flags() | ItemIsSelectable | ItemIsFocusable);
+    setFlags(flags() | ItemIsSelectable | ItemIsFocusable | ItemUsesExtendedStyleOption);
     setCacheMode(QGraphicsItem::DeviceCoordinateCache);
     setTransformationMode(Qt::SmoothTransformation);
     setZValue(0);
@@ -191,7 +677,7 @@ GraphicsPixmapItem::~GraphicsPixmapItem() = default;
 void GraphicsPixmapItem::setSourcePixmap(const QPixmap &pixmap)
 {
     setPixmap(pixmap);
-    if (pixmap.size() != d_ptr->maskPainter.maskImage().size()) {
+    if (pixmap.size() != d_ptr->maskPainter.size()) {
         resetMask();
     }
     setBrushSize(qMin(pixmap.width(), pixmap.height()) / 20);
@@ -208,6 +694,7 @@ void GraphicsPixmapItem::setMaskImage(const QImage &mask)
     }
 
     d_ptr->maskPainter.setMaskImage(mask);
+    d_ptr->maskHistory.clear();
     update();
 }
 
@@ -222,7 +709,6 @@ void GraphicsPixmapItem::setMaskEditingMode(MaskEditingMode mode)
         return;
     }
     d_ptr->editingMode = mode;
-    d_ptr->cursorManager.setNeedsUpdate(true);
     updateCursor();
 }
 
@@ -231,6 +717,22 @@ auto GraphicsPixmapItem::maskEditingMode() const -> MaskEditingMode
     return d_ptr->editingMode;
 }
 
+void GraphicsPixmapItem::setMaskEditingEnabled(bool enabled)
+{
+    if (d_ptr->editingEnabled == enabled) {
+        return;
+    }
+    if (!enabled) {
+        endStroke();
+    }
+    d_ptr->editingEnabled = enabled;
+}
+
+auto GraphicsPixmapItem::maskEditingEnabled() const -> bool
+{
+    return d_ptr->editingEnabled;
+}
+
 void GraphicsPixmapItem::setBrushSize(int size)
 {
     if (d_ptr->cursorManager.brushSize() == size) {
@@ -238,7 +740,6 @@ void GraphicsPixmapItem::setBrushSize(int size)
     }
 
     d_ptr->cursorManager.setBrushSize(size);
-    d_ptr->cursorManager.setNeedsUpdate(true);
     updateCursor();
 }
 
@@ -261,13 +762,26 @@ auto GraphicsPixmapItem::maskOpacity() const -> double
     return d_ptr->maskPainter.opacity();
 }
 
+void GraphicsPixmapItem::setMaskColor(const QColor &color)
+{
+    if (d_ptr->maskPainter.color() == color) {
+        return;
+    }
+    d_ptr->maskPainter.setColor(color);
+    update();
+}
+
+auto GraphicsPixmapItem::maskColor() const -> QColor
+{
+    return d_ptr->maskPainter.color();
+}
+
 void GraphicsPixmapItem::setCheckerColor1(const QColor &color)
 {
     if (d_ptr->cursorManager.checkerColor1() == color) {
         return;
     }
     d_ptr->cursorManager.setCheckerColor1(color);
-    d_ptr->cursorManager.setNeedsUpdate(true);
     updateCursor();
 }
 
@@ -282,7 +796,6 @@ void GraphicsPixmapItem::setCheckerColor2(const QColor &color)
         return;
     }
     d_ptr->cursorManager.setCheckerColor2(color);
-    d_ptr->cursorManager.setNeedsUpdate(true);
     updateCursor();
 }
 
@@ -296,47 +809,87 @@ void GraphicsPixmapItem::resetMask()
     if (!pixmap().isNull()) {
         d_ptr->maskPainter.reset(pixmap().size());
     }
+    d_ptr->maskHistory.clear();
     update();
 }
 
+void GraphicsPixmapItem::undoMask()
+{
+    if (!d_ptr->editingEnabled || !d_ptr->maskHistory.canUndo()) {
+        return;
+    }
+    update(d_ptr->maskPainter.applyEdit(d_ptr->maskHistory.undo(), true));
+}
+
+void GraphicsPixmapItem::redoMask()
+{
+    if (!d_ptr->editingEnabled || !d_ptr->maskHistory.canRedo()) {
+        return;
+    }
+    update(d_ptr->maskPainter.applyEdit(d_ptr->maskHistory.redo(), false));
+}
+
+auto GraphicsPixmapItem::canUndoMask() const -> bool
+{
+    return d_ptr->maskHistory.canUndo();
+}
+
+auto GraphicsPixmapItem::canRedoMask() const -> bool
+{
+    return d_ptr->maskHistory.canRedo();
+}
+
+void GraphicsPixmapItem::setMaskHistoryLimit(qint64 bytes)
+{
+    d_ptr->maskHistory.setMemoryLimit(bytes);
+}
+
+auto GraphicsPixmapItem::maskHistoryLimit() const -> qint64
+{
+    return d_ptr->maskHistory.memoryLimit();
+}
+
 void GraphicsPixmapItem::updateMaskWithBrushStroke()
 {
     if (!d_ptr->maskPainter.isValid()) {
         return;
     }
 
-    QImage maskCopy = d_ptr->maskPainter.maskImage();
-    QPainter painter(&maskCopy);
     QPen pen;
     pen.setWidth(d_ptr->cursorManager.brushSize());
     pen.setCapStyle(Qt::RoundCap);
 
-    // 根据模式设置画笔图案
-    if (d_ptr->editingMode == MaskEditingMode::Erase) {
-        pen.setBrush(Qt::white);
-        painter.setCompositionMode(QPainter::CompositionMode_Clear);
-    } else {
-        QPixmap brushPattern = d_ptr->cursorManager.currentBrushPattern();
-        if (!brushPattern.isNull()) {
-            pen.setBrush(brushPattern);
-        }
-    }
-
-    painter.setPen(pen);
+    // 遮罩只保存覆盖率，颜色在绘制时着色
+    const auto erase = d_ptr->editingMode == MaskEditingMode::Erase;
+    pen.setBrush(Qt::white);
 
     const QPointF lastLocal = mapFromScene(d_ptr->maskPainter.lastBrushPosition());
     const QPointF currLocal = mapFromScene(d_ptr->maskPainter.currentBrushPosition());
-    painter.drawLine(lastLocal, currLocal);
+    const auto dirtyRect = d_ptr->maskPainter.drawLine(lastLocal, currLocal, pen, erase);
 
-    d_ptr->maskPainter.setMaskImage(maskCopy);
     d_ptr->maskPainter.setLastBrushPosition(d_ptr->maskPainter.currentBrushPosition());
-    update();
+    // 只重绘这一段笔画覆盖的区域
+    if (!dirtyRect.isEmpty()) {
+        update(dirtyRect);
+    }
+}
+
+void GraphicsPixmapItem::endStroke()
+{
+    const auto edit = d_ptr->maskPainter.endStroke();
+    if (!edit.tiles.isEmpty()) {
+        d_ptr->maskHistory.push(edit);
+    }
 }
 
 void GraphicsPixmapItem::updateCursor()
 {
-    setCursor(d_ptr->cursorManager.createCursorForMode(d_ptr->editingMode));
-    d_ptr->cursorManager.setNeedsUpdate(false);
+    setCursor(d_ptr->cursorManager.cursorForMode(d_ptr->editingMode));
+}
+
+auto GraphicsPixmapItem::isPaintingMask() const -> bool
+{
+    return d_ptr->editingEnabled && d_ptr->editingMode != MaskEditingMode::Normal;
 }
 
 void GraphicsPixmapItem::mousePressEvent(QGraphicsSceneMouseEvent *event)
@@ -348,6 +901,9 @@ void GraphicsPixmapItem::mousePressEvent(QGraphicsSceneMouseEvent *event)
     }
     d_ptr->maskPainter.setLastBrushPosition(event->scenePos());
     d_ptr->maskPainter.setCurrentBrushPosition(d_ptr->maskPainter.lastBrushPosition());
+    if (isPaintingMask()) {
+        d_ptr->maskPainter.beginStroke();
+    }
 }
 
 void GraphicsPixmapItem::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
@@ -356,7 +912,8 @@ void GraphicsPixmapItem::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
 
     if (event->buttons() & Qt::LeftButton) {
         d_ptr->maskPainter.setCurrentBrushPosition(event->scenePos());
-        if (d_ptr->editingMode != MaskEditingMode::Normal
+        // 只在按下时开始的笔画上绘制，保证每一笔都能撤销
+        if (isPaintingMask() && d_ptr->maskPainter.isRecording()
             && d_ptr->maskPainter.currentBrushPosition() != d_ptr->maskPainter.lastBrushPosition()) {
             updateMaskWithBrushStroke();
         }
@@ -372,6 +929,7 @@ void GraphicsPixmapItem::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
     }
     d_ptr->maskPainter.setLastBrushPosition(QPointF());
     d_ptr->maskPainter.setCurrentBrushPosition(QPointF());
+    endStroke();
 }
 
 void GraphicsPixmapItem::mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event)
@@ -386,6 +944,17 @@ void GraphicsPixmapItem::mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event)
     d_ptr->maskPainter.setCurrentBrushPosition(QPointF());
 }
 
+void GraphicsPixmapItem::keyPressEvent(QKeyEvent *event)
+{
+    if (event->matches(QKeySequence::Undo)) {
+        undoMask();
+    } else if (event->matches(QKeySequence::Redo)) {
+        redoMask();
+    } else {
+        QGraphicsPixmapItem::keyPressEvent(event);
+    }
+}
+
 void GraphicsPixmapItem::paint(QPainter *painter,
                                const QStyleOptionGraphicsItem *option,
                                QWidget *widget)
@@ -395,20 +964,34 @@ void GraphicsPixmapItem::paint(QPainter *painter,
     // op.initFrom(widget);
     op.state = QStyle::State_None;
 
-    QGraphicsPixmapItem::paint(painter, &op, widget);
+    // 缩小时从接近显示比例的 mipmap 绘制，避免每次重绘都重采样整张原图
+    const auto scale = QStyleOptionGraphicsItem::levelOfDetailFromTransform(
+                           painter->worldTransform())
+                       * painter->device()->devicePixelRatioF();
+    const auto level = d_ptr->mipLevel(scale);
+    if (level == 0) {
+        QGraphicsPixmapItem::paint(painter, &op, widget);
+    } else {
+        const auto &mipmap = d_ptr->mipLevels.at(level - 1);
+        painter->save();
+        painter->setRenderHint(QPainter::SmoothPixmapTransform,
+                               transformationMode() == Qt::SmoothTransformation);
+        painter->drawPixmap(QRectF(offset(), pixmap().deviceIndependentSize()),
+                            mipmap,
+                            QRectF(mipmap.rect()));
+        painter->restore();
+    }
 
     if (!d_ptr->maskPainter.isValid()) {
         return;
     }
 
-    painter->setRenderHint(QPainter::Antialiasing);
-    painter->setOpacity(d_ptr->maskPainter.opacity());
-    painter->drawImage(0, 0, d_ptr->maskPainter.maskImage());
+    d_ptr->maskPainter.paint(painter, option->exposedRect);
 
     // 更新光标缩放因子
-    d_ptr->cursorManager.updateScaleFactor(painter);
-    if (d_ptr->cursorManager.needsUpdate()) {
-        updateCursor();
+    if (d_ptr->cursorManager.updateScaleFactor(painter)
+        && d_ptr->editingMode != MaskEditingMode::Normal) {
+        d_ptr->cursorTimer.start();
     }
 }
 
@@ -16,18 +16,29 @@ public:
 
     void setSourcePixmap(const QPixmap &pixmap);
 
+    // The mask is stored as coverage only. Masks with an alpha channel use it, and
+    // Grayscale8 masks use the gray value. maskImage() returns Format_Alpha8.
     void setMaskImage(const QImage &mask);
     [[nodiscard]] auto maskImage() const -> QImage;
 
     void setMaskEditingMode(MaskEditingMode mode);
     [[nodiscard]] auto maskEditingMode() const -> MaskEditingMode;
 
+    // While disabled, strokes, undo and redo are ignored. GraphicsView disables editing
+    // while a reduced resolution preview is shown, since the full resolution image
+    // replaces the mask once it is loaded.
+    void setMaskEditingEnabled(bool enabled);
+    [[nodiscard]] auto maskEditingEnabled() const -> bool;
+
     void setBrushSize(int size);
     [[nodiscard]] auto brushSize() const -> int;
 
     void setMaskOpacity(double opacity);
     auto maskOpacity() const -> double;
 
+    void setMaskColor(const QColor &color);
+    [[nodiscard]] auto maskColor() const -> QColor;
+
     void setCheckerColor1(const QColor &color);
     auto checkerColor1() const -> QColor;
 
@@ -36,16 +47,28 @@ public:
 
     void resetMask();
 
+    // Each stroke keeps only the compressed tiles it touched, the oldest strokes are
+    // dropped once the history exceeds the limit.
+    void undoMask();
+    void redoMask();
+    [[nodiscard]] auto canUndoMask() const -> bool;
+    [[nodiscard]] auto canRedoMask() const -> bool;
+    void setMaskHistoryLimit(qint64 bytes);
+    [[nodiscard]] auto maskHistoryLimit() const -> qint64;
+
 protected:
     void mousePressEvent(QGraphicsSceneMouseEvent *event) override;
     void mouseMoveEvent(QGraphicsSceneMouseEvent *event) override;
     void mouseReleaseEvent(QGraphicsSceneMouseEvent *event) override;
     void mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
 
 private:
     void updateMaskWithBrushStroke();
+    void endStroke();
     void updateCursor();
+    [[nodiscard]] auto isPaintingMask() const -> bool;
 
     class GraphicsPixmapItemPrivate;
     QScopedPointer<GraphicsPixmapItemPrivate> d_ptr;
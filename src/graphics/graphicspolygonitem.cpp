@@ -5,11 +5,18 @@
 #include <QGraphicsScene>
 #include <QGraphicsSceneHoverEvent>
 #include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+#include <cmath>
 
 namespace Graphics {
 
 namespace {
 
+// 顶点数不超过这个值的多边形不抽稀
+constexpr qsizetype DecimationThreshold = 256;
+constexpr int MaxDetailLevel = 16;
+
 auto checkPolygonVaild(const QPolygonF &ply, const double margin) -> bool
 {
     auto rect = ply.boundingRect();
@@ -39,9 +46,32 @@ public:
         : q_ptr(q)
     {}
 
+    void setPolygon(const QPolygonF &ply)
+    {
+        polygon = ply;
+        levels.clear();
+    }
+
+    // 第 level 层允许的误差是 2^level / 2 个单位，lod 落在 (2^-(level+1), 2^-level] 时
+    // 误差不超过半个像素。放大到 1:1 以上或顶点不多时直接用完整的多边形
+    auto polygonForDetail(double lod) -> const QPolygonF &
+    {
+        if (polygon.size() <= DecimationThreshold || lod >= 1 || lod <= 0) {
+            return polygon;
+        }
+        const int level = std::min(static_cast<int>(std::floor(std::log2(1 / lod))),
+                                   MaxDetailLevel);
+        auto it = levels.find(level);
+        if (it == levels.end()) {
+            it = levels.insert(level, Utils::simplifyPolygon(polygon, std::ldexp(0.5, level)));
+        }
+        return it.value();
+    }
+
     GraphicsPolygonItem *q_ptr;
 
-    QPolygonF polygon;
+    QPolygonF polygon;            // 完整的多边形，用于编辑和导出
+    QHash<int, QPolygonF> levels; // 按细节层级缓存的抽稀结果，用于绘制
 };
 
 GraphicsPolygonItem::GraphicsPolygonItem(QGraphicsItem *parent)
@@ -65,13 +95,21 @@ auto GraphicsPolygonItem::setPolygon(const QPolygonF &ply) -> bool
     }
 
     auto rect = Utils::createBoundingRect(ply, margin());
-    if (!scene()->sceneRect().contains(rect)) {
+    if (scene() && !scene()->sceneRect().contains(rect)) {
         return false;
     }
 
+    // 命中测试的形状本来就按 margin 扩展过，抽稀到四分之一 margin 的误差后再合并路径
+    const auto hitPolygon = ply.size() > DecimationThreshold
+                                ? Utils::simplifyPolygon(ply, margin() * 0.25)
+                                : ply;
+
     prepareGeometryChange();
-    d_ptr->polygon = ply;
-    geometryCache()->setGeometryData(ply, Utils::createBoundingRect(ply, 0), simplifiedPath(ply));
+    d_ptr->setPolygon(ply);
+    geometryCache()->setGeometryData(ply,
+                                     Utils::createBoundingRect(ply, 0),
+                                     simplifiedPath(hitPolygon));
+    emit geometryChanged();
 
     return true;
 }
@@ -83,10 +121,12 @@ auto GraphicsPolygonItem::polygon() const -> QPolygonF
 
 void GraphicsPolygonItem::drawContent(QPainter *painter)
 {
+    const auto &polygon = d_ptr->polygonForDetail(
+        QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform()));
     if (isValid()) {
-        painter->drawPolygon(d_ptr->polygon);
+        painter->drawPolygon(polygon);
     } else {
-        painter->drawPolyline(d_ptr->polygon);
+        painter->drawPolyline(polygon);
     }
 }
 
@@ -118,7 +158,7 @@ void GraphicsPolygonItem::updateHoverPreview(const QPointF &scenePos)
         return;
     }
 
-    d_ptr->polygon = polygon;
+    d_ptr->setPolygon(polygon);
     update();
 }
 
@@ -90,7 +90,7 @@ auto GraphicsRingItem::setRing(const Ring &ring) -> bool
         return false;
     }
     auto rect = ring.boundingRect(margin());
-    if (!scene()->sceneRect().contains(rect)) {
+    if (scene() && !scene()->sceneRect().contains(rect)) {
         return false;
     }
     rect = ring.boundingRect(0);
@@ -103,7 +103,23 @@ auto GraphicsRingItem::setRing(const Ring &ring) -> bool
     prepareGeometryChange();
 
     d_ptr->ring = ring;
-    geometryCache()->setGeometryData(ring.controlPoints(), rect, shape);
+    // 圆环扩展后仍是圆环，直接构造，不需要描边再合并
+    geometryCache()->setGeometryData(ring.controlPoints(),
+                                     rect,
+                                     shape,
+                                     [ring](double expansion) -> QPainterPath {
+                                         const double half = expansion / 2;
+                                         QPainterPath path;
+                                         path.addEllipse(ring.center,
+                                                         ring.maxRadius + half,
+                                                         ring.maxRadius + half);
+                                         const double inner = ring.minRadius - half;
+                                         if (inner > 0) {
+                                             path.addEllipse(ring.center, inner, inner);
+                                         }
+                                         return path;
+                                     });
+    emit geometryChanged();
 
     return true;
 }
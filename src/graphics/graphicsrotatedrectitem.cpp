@@ -217,7 +217,7 @@ auto GraphicsRotatedRectItem::setRotatedRect(const RotatedRect &rotatedRect) ->
     }
     auto anchorPoints = rotatedRect.controlPoints();
     auto rect = Utils::createBoundingRect(anchorPoints, margin());
-    if (!scene()->sceneRect().contains(rect)) {
+    if (scene() && !scene()->sceneRect().contains(rect)) {
         return false;
     }
     rect = Utils::createBoundingRect(anchorPoints, 0);
@@ -231,6 +231,7 @@ auto GraphicsRotatedRectItem::setRotatedRect(const RotatedRect &rotatedRect) ->
     d_ptr->rotatedRect = rotatedRect;
 
     geometryCache()->setGeometryData(anchorPoints, rect, shape);
+    emit geometryChanged();
 
     return true;
 }
@@ -60,7 +60,7 @@ auto GraphicsRoundedRectItem::setRoundedRect(const RoundedRect &roundedRect) ->
 
     QPolygonF anchorPoints{roundedRect.rect.topLeft(), roundedRect.rect.bottomRight()};
     auto rect = Utils::createBoundingRect(anchorPoints, margin());
-    if (!scene()->sceneRect().contains(rect)) {
+    if (scene() && !scene()->sceneRect().contains(rect)) {
         return false;
     }
     QPainterPath shape;
@@ -72,6 +72,7 @@ auto GraphicsRoundedRectItem::setRoundedRect(const RoundedRect &roundedRect) ->
                                      Utils::createBoundingRect(anchorPoints, 0),
                                      shape);
     emit roundedRectChanged(m_roundedRect);
+    emit geometryChanged();
 
     return true;
 }
@@ -0,0 +1,901 @@
+#include "graphicsshapelayer.hpp"
+#include "graphicspolygonitem.h"
+#include "graphicsrectitem.h"
+#include "graphicsutils.hpp"
+
+#include <QBitArray>
+#include <QGraphicsScene>
+#include <QGraphicsSceneMouseEvent>
+#include <QPainter>
+#include <QPainterPath>
+#include <QPen>
+#include <QPointer>
+#include <QStyleOptionGraphicsItem>
+#include <QtMath>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace Graphics {
+
+namespace {
+
+// 屏幕上小于这个像素数的图形画成一个点
+constexpr double MinPixelSize = 2;
+// 跨越格子数超过这个值的图形不放进网格，每次查询都检查
+constexpr qint64 MaxCellsPerShape = 64;
+
+auto overlaps(const QRectF &lhs, const QRectF &rhs) -> bool
+{
+    // QRectF::intersects 对宽或高为 0 的矩形返回 false，退化的图形也需要参与查询
+    return lhs.left() <= rhs.right() && lhs.right() >= rhs.left() && lhs.top() <= rhs.bottom()
+           && lhs.bottom() >= rhs.top();
+}
+
+auto nearPolyline(const QPointF *points, int count, const QPointF &pos, double margin) -> bool
+{
+    for (int i = 0; i < count; ++i) {
+        if (Utils::isPointNearEdge(pos, QLineF(points[i], points[(i + 1) % count]), margin)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 射线法，直接在顶点数组上判断，不复制成 QPolygonF
+auto containsPoint(const QPointF *points, int count, const QPointF &pos, Qt::FillRule fillRule)
+    -> bool
+{
+    int crossings = 0;
+    int winding = 0;
+    for (int i = 0; i < count; ++i) {
+        const auto &from = points[i];
+        const auto &to = points[(i + 1) % count];
+        if ((from.y() <= pos.y()) == (to.y() <= pos.y())) {
+            continue;
+        }
+        const auto x = from.x() + (pos.y() - from.y()) * (to.x() - from.x()) / (to.y() - from.y());
+        if (x > pos.x()) {
+            ++crossings;
+            winding += to.y() > from.y() ? 1 : -1;
+        }
+    }
+    return fillRule == Qt::OddEvenFill ? (crossings & 1) != 0 : winding != 0;
+}
+
+// 鞋带公式，大于 0 为顺时针（y 轴向下）
+auto signedArea(const QPointF *points, int count) -> double
+{
+    double area = 0;
+    for (int i = 0; i < count; ++i) {
+        const auto &from = points[i];
+        const auto &to = points[(i + 1) % count];
+        area += from.x() * to.y() - to.x() * from.y();
+    }
+    return area;
+}
+
+// 批量绘制时所有子路径都按顺时针添加，WindingFill 下重叠的图形取并集而不是互相挖空
+void addPolygon(QPainterPath &path, const QPointF *points, int count)
+{
+    if (count < 2) {
+        return;
+    }
+    if (signedArea(points, count) >= 0) {
+        path.moveTo(points[0]);
+        for (int i = 1; i < count; ++i) {
+            path.lineTo(points[i]);
+        }
+    } else {
+        path.moveTo(points[count - 1]);
+        for (int i = count - 2; i >= 0; --i) {
+            path.lineTo(points[i]);
+        }
+    }
+    path.closeSubpath();
+}
+
+// 只支持平移、旋转和等比缩放，旋转矩形和圆映射后形状不变
+auto similarity(const QTransform &transform, double &scale, double &angle) -> bool
+{
+    if (!transform.isAffine() || transform.determinant() <= 0) {
+        return false;
+    }
+    const auto scaleX = std::hypot(transform.m11(), transform.m12());
+    const auto scaleY = std::hypot(transform.m21(), transform.m22());
+    const auto shear = transform.m11() * transform.m21() + transform.m12() * transform.m22();
+    if (!qFuzzyCompare(scaleX, scaleY) || !qFuzzyIsNull(shear / (scaleX * scaleY))) {
+        return false;
+    }
+    scale = scaleX;
+    angle = qRadiansToDegrees(std::atan2(transform.m12(), transform.m11()));
+    return true;
+}
+
+auto mapRotatedRect(const RotatedRect &rotatedRect,
+                    const QTransform &transform,
+                    RotatedRect &mapped) -> bool
+{
+    double scale = 1;
+    double angle = 0;
+    if (!similarity(transform, scale, angle)) {
+        return false;
+    }
+    mapped.center = transform.map(rotatedRect.center);
+    mapped.width = rotatedRect.width * scale;
+    mapped.height = rotatedRect.height * scale;
+    mapped.angle = Utils::normalizeAngle(rotatedRect.angle + angle);
+    return true;
+}
+
+auto mapCircle(const Circle &circle, const QTransform &transform, Circle &mapped) -> bool
+{
+    double scale = 1;
+    double angle = 0;
+    if (!similarity(transform, scale, angle)) {
+        return false;
+    }
+    mapped.center = transform.map(circle.center);
+    mapped.radius = circle.radius * scale;
+    return true;
+}
+
+} // namespace
+
+class GraphicsShapeLayer::GraphicsShapeLayerPrivate
+{
+public:
+    explicit GraphicsShapeLayerPrivate(GraphicsShapeLayer *q)
+        : q_ptr(q)
+    {}
+
+    [[nodiscard]] auto count() const -> int { return static_cast<int>(types.size()); }
+
+    void append(GraphicsBasicItem::Shape type, qsizetype local, const QRectF &shapeBounds)
+    {
+        types.append(type);
+        locals.append(static_cast<int>(local));
+        bounds.append(shapeBounds);
+        layerBounds = layerBounds.isNull() ? shapeBounds : layerBounds.united(shapeBounds);
+    }
+
+    // 网格在下次查询时按新的平均尺寸重建
+    void finishAppend()
+    {
+        hidden.resize(count());
+        visitStamps.resize(count());
+        cellSize = 0;
+    }
+
+    [[nodiscard]] auto polygonPoints(int local, int &size) const -> const QPointF *
+    {
+        size = polygonOffsets.at(local + 1) - polygonOffsets.at(local);
+        return polygonBuffer.constData() + polygonOffsets.at(local);
+    }
+
+    [[nodiscard]] auto hitTest(int index, const QPointF &pos) const -> bool
+    {
+        const auto local = locals.at(index);
+        const auto tolerance = margin * 0.5;
+        switch (types.at(index)) {
+        case GraphicsBasicItem::RECT:
+            return rects.at(local)
+                .adjusted(-tolerance, -tolerance, tolerance, tolerance)
+                .contains(pos);
+        case GraphicsBasicItem::ROTATEDRECT: {
+            const auto *points = rotatedCorners.constData() + local * 4;
+            return containsPoint(points, 4, pos, Qt::OddEvenFill)
+                   || nearPolyline(points, 4, pos, tolerance);
+        }
+        case GraphicsBasicItem::CIRCLE: {
+            const auto &circle = circles.at(local);
+            return Utils::distance(pos, circle.center) <= circle.radius + tolerance;
+        }
+        case GraphicsBasicItem::POLYGON: {
+            int size = 0;
+            const auto *points = polygonPoints(local, size);
+            return containsPoint(points, size, pos, Qt::WindingFill)
+                   || nearPolyline(points, size, pos, tolerance);
+        }
+        default: return false;
+        }
+    }
+
+    // 把编辑后的场景坐标几何映射回图层坐标写回数组，返回新的边界矩形。
+    // 只在图元发出 geometryChanged 时调用，此时图元是完整的
+    auto writeBack(int index, GraphicsBasicItem *item) -> QRectF
+    {
+        const auto local = locals.at(index);
+        const auto fromScene = promotedTransform.inverted();
+        QRectF shapeBounds;
+        switch (types.at(index)) {
+        case GraphicsBasicItem::RECT: {
+            const auto rect = static_cast<GraphicsRectItem *>(item)->rect();
+            shapeBounds = rects[local] = fromScene.mapRect(rect).normalized();
+            break;
+        }
+        case GraphicsBasicItem::ROTATEDRECT: {
+            RotatedRect rotatedRect;
+            if (!mapRotatedRect(static_cast<GraphicsRotatedRectItem *>(item)->rotatedRect(),
+                                fromScene,
+                                rotatedRect)) {
+                return bounds.at(index);
+            }
+            const auto corners = rotatedRect.controlPoints();
+            rotatedRects[local] = rotatedRect;
+            std::copy(corners.cbegin(), corners.cend(), rotatedCorners.begin() + local * 4);
+            shapeBounds = corners.boundingRect();
+            break;
+        }
+        case GraphicsBasicItem::CIRCLE: {
+            Circle circle;
+            if (!mapCircle(static_cast<GraphicsCircleItem *>(item)->circle(), fromScene, circle)) {
+                return bounds.at(index);
+            }
+            circles[local] = circle;
+            shapeBounds = circle.boundingRect(0);
+            break;
+        }
+        case GraphicsBasicItem::POLYGON: {
+            const auto polygon = fromScene.map(static_cast<GraphicsPolygonItem *>(item)->polygon());
+            const auto begin = polygonOffsets.at(local);
+            const auto delta = static_cast<int>(polygon.size())
+                               - (polygonOffsets.at(local + 1) - begin);
+            if (delta > 0) {
+                polygonBuffer.insert(begin, delta, QPointF());
+            } else if (delta < 0) {
+                polygonBuffer.remove(begin, -delta);
+            }
+            std::copy(polygon.cbegin(), polygon.cend(), polygonBuffer.begin() + begin);
+            for (int i = local + 1; i < polygonOffsets.size(); ++i) {
+                polygonOffsets[i] += delta;
+            }
+            shapeBounds = polygon.boundingRect();
+            break;
+        }
+        default: return bounds.at(index);
+        }
+
+        removeFromGrid(index);
+        bounds[index] = shapeBounds;
+        insertIntoGrid(index);
+        return shapeBounds;
+    }
+
+    [[nodiscard]] auto cellRange(const QRectF &rect) const -> QRect
+    {
+        return QRect(QPoint(static_cast<int>(std::floor(rect.left() / cellSize)),
+                            static_cast<int>(std::floor(rect.top() / cellSize))),
+                     QPoint(static_cast<int>(std::floor(rect.right() / cellSize)),
+                            static_cast<int>(std::floor(rect.bottom() / cellSize))));
+    }
+
+    static auto cellKey(int x, int y) -> quint64
+    {
+        return (static_cast<quint64>(static_cast<quint32>(x)) << 32) | static_cast<quint32>(y);
+    }
+
+    void insertIntoGrid(int index) const
+    {
+        if (cellSize <= 0) {
+            return;
+        }
+        const auto range = cellRange(bounds.at(index));
+        if (static_cast<qint64>(range.width()) * range.height() > MaxCellsPerShape) {
+            largeShapes.append(index);
+            return;
+        }
+        for (int y = range.top(); y <= range.bottom(); ++y) {
+            for (int x = range.left(); x <= range.right(); ++x) {
+                grid[cellKey(x, y)].append(index);
+            }
+        }
+    }
+
+    void removeFromGrid(int index) const
+    {
+        if (cellSize <= 0) {
+            return;
+        }
+        const auto range = cellRange(bounds.at(index));
+        if (static_cast<qint64>(range.width()) * range.height() > MaxCellsPerShape) {
+            largeShapes.removeOne(index);
+            return;
+        }
+        for (int y = range.top(); y <= range.bottom(); ++y) {
+            for (int x = range.left(); x <= range.right(); ++x) {
+                const auto key = cellKey(x, y);
+                auto &indexes = grid[key];
+                indexes.removeOne(index);
+                if (indexes.isEmpty()) {
+                    grid.remove(key);
+                }
+            }
+        }
+    }
+
+    // 格子边长取图形平均尺寸的两倍，多数图形只落在 1 到 4 个格子里
+    void ensureGrid() const
+    {
+        if (cellSize > 0) {
+            return;
+        }
+        grid.clear();
+        largeShapes.clear();
+        double extent = 0;
+        for (const auto &rect : std::as_const(bounds)) {
+            extent += std::max(rect.width(), rect.height());
+        }
+        cellSize = std::max(bounds.isEmpty() ? 1.0 : extent / bounds.size() * 2, 1.0);
+        for (int i = 0; i < count(); ++i) {
+            insertIntoGrid(i);
+        }
+    }
+
+    // 对与 rect 相交且未隐藏的图形调用 visit，每个图形最多一次
+    template<typename Visitor>
+    void forEachShape(const QRectF &rect, Visitor visit) const
+    {
+        ensureGrid();
+        const auto range = cellRange(rect);
+        if (static_cast<qint64>(range.width()) * range.height() > grid.size()) {
+            // 缩得很小时格子比图形还多，直接遍历边界矩形更快
+            for (int i = 0; i < count(); ++i) {
+                if (!hidden.testBit(i) && overlaps(bounds.at(i), rect)) {
+                    visit(i);
+                }
+            }
+            return;
+        }
+
+        if (++visitMark == 0) {
+            visitStamps.fill(0);
+            visitMark = 1;
+        }
+        auto check = [&](int index) {
+            if (visitStamps.at(index) == visitMark) {
+                return;
+            }
+            visitStamps[index] = visitMark;
+            if (!hidden.testBit(index) && overlaps(bounds.at(index), rect)) {
+                visit(index);
+            }
+        };
+        for (int y = range.top(); y <= range.bottom(); ++y) {
+            for (int x = range.left(); x <= range.right(); ++x) {
+                const auto it = grid.constFind(cellKey(x, y));
+                if (it == grid.cend()) {
+                    continue;
+                }
+                for (const auto index : it.value()) {
+                    check(index);
+                }
+            }
+        }
+        for (const auto index : std::as_const(largeShapes)) {
+            check(index);
+        }
+    }
+
+    // GraphicsBasicItem 按场景坐标编辑（scenePos、sceneRect），提升的图元抵消图层的变换，
+    // 自身坐标就是场景坐标，几何在提升和写回时映射
+    auto createItem(int index, const QTransform &toScene) -> GraphicsBasicItem *
+    {
+        const auto local = locals.at(index);
+        switch (types.at(index)) {
+        case GraphicsBasicItem::RECT: {
+            if (toScene.type() > QTransform::TxScale) {
+                return nullptr; // 旋转后不再是轴对齐矩形
+            }
+            auto *item = newItem<GraphicsRectItem>(toScene);
+            return initItem(item, item->setRect(toScene.mapRect(rects.at(local)).normalized()));
+        }
+        case GraphicsBasicItem::ROTATEDRECT: {
+            RotatedRect rotatedRect;
+            if (!mapRotatedRect(rotatedRects.at(local), toScene, rotatedRect)) {
+                return nullptr;
+            }
+            auto *item = newItem<GraphicsRotatedRectItem>(toScene);
+            return initItem(item, item->setRotatedRect(rotatedRect));
+        }
+        case GraphicsBasicItem::CIRCLE: {
+            Circle circle;
+            if (!mapCircle(circles.at(local), toScene, circle)) {
+                return nullptr;
+            }
+            auto *item = newItem<GraphicsCircleItem>(toScene);
+            return initItem(item, item->setCircle(circle));
+        }
+        case GraphicsBasicItem::POLYGON: {
+            int size = 0;
+            const auto *points = polygonPoints(local, size);
+            const QPolygonF polygon(QList<QPointF>(points, points + size));
+            auto *item = newItem<GraphicsPolygonItem>(toScene);
+            return initItem(item, item->setPolygon(toScene.map(polygon)));
+        }
+        default: return nullptr;
+        }
+    }
+
+    template<typename Item>
+    auto newItem(const QTransform &toScene) -> Item *
+    {
+        auto *item = new Item(q_ptr);
+        item->setTransform(toScene.inverted());
+        return item;
+    }
+
+    // 图形加上描边后的重绘区域
+    [[nodiscard]] auto paintRect(const QRectF &rect) const -> QRectF
+    {
+        const auto offset = pen.widthF() * 0.5 + 1;
+        return rect.adjusted(-offset, -offset, offset, offset);
+    }
+
+    auto initItem(GraphicsBasicItem *item, bool accepted) -> GraphicsBasicItem *
+    {
+        if (!accepted) {
+            delete item;
+            return nullptr;
+        }
+        item->setPen(pen);
+        item->setBrush(brush);
+        return item;
+    }
+
+    GraphicsShapeLayer *q_ptr;
+
+    // 每个图形一项，locals 是在对应类型数组中的下标
+    QList<GraphicsBasicItem::Shape> types;
+    QList<int> locals;
+    QList<QRectF> bounds;
+    QBitArray hidden;
+    QRectF layerBounds;
+
+    QList<QRectF> rects;
+    QList<RotatedRect> rotatedRects;
+    QPolygonF rotatedCorners; // 每个旋转矩形 4 个角点
+    QList<Circle> circles;
+    QPolygonF polygonBuffer;       // 所有多边形的顶点首尾相接
+    QList<int> polygonOffsets{0}; // 第 i 个多边形是 [offsets[i], offsets[i + 1])
+
+    QPen pen{QColor(57, 163, 255), 2};
+    QBrush brush;
+    double margin = 6;
+
+    int promotedIndex = -1;
+    QPointer<GraphicsBasicItem> promotedItem;
+    QGraphicsItem *promotedGraphicsItem = nullptr; // 只用于与子图元比较指针
+    QTransform promotedTransform; // 提升时图层到场景的变换
+
+    mutable QHash<quint64, QList<int>> grid; // 网格到图形下标
+    mutable QList<int> largeShapes;
+    mutable double cellSize = 0; // 为 0 时需要重建
+    mutable QList<quint32> visitStamps;
+    mutable quint32 visitMark = 0;
+};
+
+GraphicsShapeLayer::GraphicsShapeLayer(QGraphicsItem *parent)
+    : QGraphicsObject(parent)
+    , d_ptr(new GraphicsShapeLayerPrivate(this))
+{
+    setFlags(flags() | ItemUsesExtendedStyleOption | ItemSendsGeometryChanges);
+    connect(this, &QGraphicsObject::childrenChanged, this, &GraphicsShapeLayer::onChildrenChanged);
+}
+
+GraphicsShapeLayer::~GraphicsShapeLayer()
+{
+    // 子图元在基类析构时删除，那时 d_ptr 已经不在了，先断开所有会用到它的连接
+    if (d_ptr->promotedItem) {
+        d_ptr->promotedItem->disconnect(this);
+    }
+    disconnect(this, &QGraphicsObject::childrenChanged, this, nullptr);
+    if (auto *scene = this->scene()) {
+        disconnect(scene, &QGraphicsScene::selectionChanged, this, nullptr);
+    }
+}
+
+auto GraphicsShapeLayer::addRects(const QList<QRectF> &rects) -> int
+{
+    prepareGeometryChange();
+    const auto first = d_ptr->count();
+    d_ptr->types.reserve(first + rects.size());
+    for (const auto &rect : rects) {
+        const auto normalized = rect.normalized();
+        d_ptr->append(GraphicsBasicItem::RECT, d_ptr->rects.size(), normalized);
+        d_ptr->rects.append(normalized);
+    }
+    d_ptr->finishAppend();
+    update();
+    return first;
+}
+
+auto GraphicsShapeLayer::addRotatedRects(const QList<RotatedRect> &rotatedRects) -> int
+{
+    prepareGeometryChange();
+    const auto first = d_ptr->count();
+    d_ptr->rotatedCorners.reserve(d_ptr->rotatedCorners.size() + rotatedRects.size() * 4);
+    for (const auto &rotatedRect : rotatedRects) {
+        const auto corners = rotatedRect.controlPoints();
+        d_ptr->append(GraphicsBasicItem::ROTATEDRECT,
+                      d_ptr->rotatedRects.size(),
+                      corners.boundingRect());
+        d_ptr->rotatedRects.append(rotatedRect);
+        d_ptr->rotatedCorners.append(corners);
+    }
+    d_ptr->finishAppend();
+    update();
+    return first;
+}
+
+auto GraphicsShapeLayer::addCircles(const QList<Circle> &circles) -> int
+{
+    prepareGeometryChange();
+    const auto first = d_ptr->count();
+    for (const auto &circle : circles) {
+        d_ptr->append(GraphicsBasicItem::CIRCLE, d_ptr->circles.size(), circle.boundingRect(0));
+        d_ptr->circles.append(circle);
+    }
+    d_ptr->finishAppend();
+    update();
+    return first;
+}
+
+auto GraphicsShapeLayer::addPolygons(const QList<QPolygonF> &polygons) -> int
+{
+    prepareGeometryChange();
+    const auto first = d_ptr->count();
+    for (const auto &polygon : polygons) {
+        d_ptr->append(GraphicsBasicItem::POLYGON,
+                      d_ptr->polygonOffsets.size() - 1,
+                      polygon.boundingRect());
+        d_ptr->polygonBuffer.append(polygon);
+        d_ptr->polygonOffsets.append(static_cast<int>(d_ptr->polygonBuffer.size()));
+    }
+    d_ptr->finishAppend();
+    update();
+    return first;
+}
+
+void GraphicsShapeLayer::clear()
+{
+    demote();
+    prepareGeometryChange();
+    d_ptr->types.clear();
+    d_ptr->locals.clear();
+    d_ptr->bounds.clear();
+    d_ptr->layerBounds = QRectF();
+    d_ptr->rects.clear();
+    d_ptr->rotatedRects.clear();
+    d_ptr->rotatedCorners.clear();
+    d_ptr->circles.clear();
+    d_ptr->polygonBuffer.clear();
+    d_ptr->polygonOffsets = {0};
+    d_ptr->finishAppend();
+    update();
+}
+
+auto GraphicsShapeLayer::count() const -> int
+{
+    return d_ptr->count();
+}
+
+auto GraphicsShapeLayer::shapeType(int index) const -> GraphicsBasicItem::Shape
+{
+    return d_ptr->types.at(index);
+}
+
+auto GraphicsShapeLayer::shapeBoundingRect(int index) const -> QRectF
+{
+    return d_ptr->bounds.at(index);
+}
+
+auto GraphicsShapeLayer::rect(int index) const -> QRectF
+{
+    Q_ASSERT(shapeType(index) == GraphicsBasicItem::RECT);
+    return d_ptr->rects.at(d_ptr->locals.at(index));
+}
+
+auto GraphicsShapeLayer::rotatedRect(int index) const -> RotatedRect
+{
+    Q_ASSERT(shapeType(index) == GraphicsBasicItem::ROTATEDRECT);
+    return d_ptr->rotatedRects.at(d_ptr->locals.at(index));
+}
+
+auto GraphicsShapeLayer::circle(int index) const -> Circle
+{
+    Q_ASSERT(shapeType(index) == GraphicsBasicItem::CIRCLE);
+    return d_ptr->circles.at(d_ptr->locals.at(index));
+}
+
+auto GraphicsShapeLayer::polygon(int index) const -> QPolygonF
+{
+    Q_ASSERT(shapeType(index) == GraphicsBasicItem::POLYGON);
+    int size = 0;
+    const auto *points = d_ptr->polygonPoints(d_ptr->locals.at(index), size);
+    return QList<QPointF>(points, points + size);
+}
+
+void GraphicsShapeLayer::setPen(const QPen &pen)
+{
+    if (d_ptr->pen == pen) {
+        return;
+    }
+    prepareGeometryChange();
+    d_ptr->pen = pen;
+    update();
+}
+
+auto GraphicsShapeLayer::pen() const -> QPen
+{
+    return d_ptr->pen;
+}
+
+void GraphicsShapeLayer::setBrush(const QBrush &brush)
+{
+    d_ptr->brush = brush;
+    update();
+}
+
+auto GraphicsShapeLayer::brush() const -> QBrush
+{
+    return d_ptr->brush;
+}
+
+void GraphicsShapeLayer::setMargin(double margin)
+{
+    d_ptr->margin = margin;
+}
+
+auto GraphicsShapeLayer::margin() const -> double
+{
+    return d_ptr->margin;
+}
+
+auto GraphicsShapeLayer::shapeAt(const QPointF &pos) const -> int
+{
+    const auto tolerance = d_ptr->margin * 0.5;
+    const QRectF area(pos.x() - tolerance, pos.y() - tolerance, tolerance * 2, tolerance * 2);
+    // 后加入的图形画在上面
+    int index = -1;
+    d_ptr->forEachShape(area, [&](int candidate) {
+        if (candidate > index && d_ptr->hitTest(candidate, pos)) {
+            index = candidate;
+        }
+    });
+    return index;
+}
+
+auto GraphicsShapeLayer::shapesIn(const QRectF &rect) const -> QList<int>
+{
+    QList<int> indexes;
+    d_ptr->forEachShape(rect.normalized(), [&indexes](int index) { indexes.append(index); });
+    std::sort(indexes.begin(), indexes.end());
+    return indexes;
+}
+
+auto GraphicsShapeLayer::promote(int index) -> GraphicsBasicItem *
+{
+    if (index < 0 || index >= count() || !scene()) {
+        return nullptr;
+    }
+    if (index == d_ptr->promotedIndex) {
+        return d_ptr->promotedItem;
+    }
+
+    demote();
+    const auto toScene = sceneTransform();
+    if (!toScene.isInvertible()) {
+        return nullptr;
+    }
+    auto *item = d_ptr->createItem(index, toScene);
+    if (!item) {
+        return nullptr;
+    }
+    item->setMargin(d_ptr->margin);
+    d_ptr->hidden.setBit(index);
+    d_ptr->promotedIndex = index;
+    d_ptr->promotedItem = item;
+    d_ptr->promotedGraphicsItem = item;
+    d_ptr->promotedTransform = toScene;
+    update(d_ptr->paintRect(d_ptr->bounds.at(index)));
+
+    // 每次编辑都写回，图元被外部删除时不需要再读取它
+    connect(item, &GraphicsBasicItem::geometryChanged, this, [this, item] {
+        onPromotedGeometryChanged(item);
+    });
+    connect(item, &QObject::destroyed, this, [this, index] {
+        if (d_ptr->promotedIndex == index && !d_ptr->promotedItem) {
+            releasePromotion();
+        }
+    });
+
+    item->setSelected(true);
+    emit shapePromoted(index, item);
+    return item;
+}
+
+void GraphicsShapeLayer::demote()
+{
+    if (!d_ptr->promotedItem) {
+        return;
+    }
+    GraphicsBasicItem *item = d_ptr->promotedItem;
+    releasePromotion();
+    // 可能在场景分发选择变化时被调用，延迟删除
+    item->disconnect(this);
+    item->setVisible(false);
+    item->deleteLater();
+}
+
+void GraphicsShapeLayer::releasePromotion()
+{
+    if (d_ptr->promotedIndex < 0) {
+        return;
+    }
+    const auto index = std::exchange(d_ptr->promotedIndex, -1);
+    d_ptr->promotedItem.clear();
+    d_ptr->promotedGraphicsItem = nullptr;
+    d_ptr->hidden.clearBit(index);
+    update(d_ptr->paintRect(d_ptr->bounds.at(index)));
+    emit shapeDemoted(index);
+}
+
+void GraphicsShapeLayer::onChildrenChanged()
+{
+    // 提升的图元被外部删除时，场景先把它从子图元中移除，再发出 selectionChanged。
+    // 此时图元已经析构了一部分，只比较提升时保存的指针并释放提升状态，不再访问它
+    if (d_ptr->promotedGraphicsItem && !childItems().contains(d_ptr->promotedGraphicsItem)) {
+        releasePromotion();
+    }
+}
+
+void GraphicsShapeLayer::onPromotedGeometryChanged(GraphicsBasicItem *item)
+{
+    if (item != d_ptr->promotedItem) {
+        return;
+    }
+    const auto index = d_ptr->promotedIndex;
+    const auto oldBounds = d_ptr->bounds.at(index);
+    const auto bounds = d_ptr->writeBack(index, item);
+    if (!d_ptr->layerBounds.contains(bounds)) {
+        prepareGeometryChange();
+        d_ptr->layerBounds = d_ptr->layerBounds.united(bounds);
+    }
+    update(d_ptr->paintRect(oldBounds.united(bounds)));
+}
+
+auto GraphicsShapeLayer::promotedItem() const -> GraphicsBasicItem *
+{
+    return d_ptr->promotedItem;
+}
+
+auto GraphicsShapeLayer::promotedIndex() const -> int
+{
+    return d_ptr->promotedIndex;
+}
+
+auto GraphicsShapeLayer::boundingRect() const -> QRectF
+{
+    if (d_ptr->layerBounds.isNull()) {
+        return {};
+    }
+    return d_ptr->paintRect(d_ptr->layerBounds);
+}
+
+void GraphicsShapeLayer::paint(QPainter *painter,
+                               const QStyleOptionGraphicsItem *option,
+                               QWidget *widget)
+{
+    Q_UNUSED(widget);
+
+    const auto lod = QStyleOptionGraphicsItem::levelOfDetailFromTransform(
+        painter->worldTransform());
+    const auto exposed = d_ptr->paintRect(option->exposedRect);
+
+    // 按类型攒成批，每种类型一次绘制调用
+    QList<QRectF> rects;
+    QList<QPointF> dots;
+    QPainterPath rotatedRects;
+    QPainterPath circles;
+    QPainterPath polygons;
+    rotatedRects.setFillRule(Qt::WindingFill);
+    circles.setFillRule(Qt::WindingFill);
+    polygons.setFillRule(Qt::WindingFill);
+    d_ptr->forEachShape(exposed, [&](int index) {
+        const auto &bounds = d_ptr->bounds.at(index);
+        if (std::max(bounds.width(), bounds.height()) * lod < MinPixelSize) {
+            dots.append(bounds.center());
+            return;
+        }
+        const auto local = d_ptr->locals.at(index);
+        switch (d_ptr->types.at(index)) {
+        case GraphicsBasicItem::RECT: rects.append(d_ptr->rects.at(local)); break;
+        case GraphicsBasicItem::ROTATEDRECT:
+            addPolygon(rotatedRects, d_ptr->rotatedCorners.constData() + local * 4, 4);
+            break;
+        case GraphicsBasicItem::CIRCLE: {
+            const auto &circle = d_ptr->circles.at(local);
+            circles.addEllipse(circle.center, circle.radius, circle.radius);
+            break;
+        }
+        case GraphicsBasicItem::POLYGON: {
+            int size = 0;
+            const auto *points = d_ptr->polygonPoints(local, size);
+            addPolygon(polygons, points, size);
+            break;
+        }
+        default: break;
+        }
+    });
+
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->setPen(d_ptr->pen);
+    painter->setBrush(d_ptr->brush);
+    if (!rects.isEmpty()) {
+        painter->drawRects(rects.constData(), static_cast<int>(rects.size()));
+    }
+    for (const auto *path : {&rotatedRects, &circles, &polygons}) {
+        if (!path->isEmpty()) {
+            painter->drawPath(*path);
+        }
+    }
+    if (!dots.isEmpty()) {
+        QPen dot(d_ptr->pen.color(), MinPixelSize);
+        dot.setCosmetic(true);
+        painter->setPen(dot);
+        painter->drawPoints(dots.constData(), static_cast<int>(dots.size()));
+    }
+}
+
+void GraphicsShapeLayer::mousePressEvent(QGraphicsSceneMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton) {
+        event->ignore();
+        return;
+    }
+    // 没点中图形时交给下面的图元
+    const auto index = shapeAt(event->pos());
+    if (index < 0 || !promote(index)) {
+        event->ignore();
+        return;
+    }
+    event->accept();
+}
+
+auto GraphicsShapeLayer::itemChange(GraphicsItemChange change, const QVariant &value) -> QVariant
+{
+    switch (change) {
+    case ItemSceneChange:
+        demote();
+        if (auto *oldScene = scene()) {
+            disconnect(oldScene, &QGraphicsScene::selectionChanged, this, nullptr);
+        }
+        break;
+    case ItemPositionHasChanged:
+    case ItemTransformHasChanged:
+        // 提升的图元按提升时的场景变换编辑
+        demote();
+        break;
+    case ItemSceneHasChanged:
+        if (auto *newScene = value.value<QGraphicsScene *>()) {
+            connect(newScene,
+                    &QGraphicsScene::selectionChanged,
+                    this,
+                    &GraphicsShapeLayer::onSelectionChanged);
+        }
+        break;
+    default: break;
+    }
+    return QGraphicsObject::itemChange(change, value);
+}
+
+void GraphicsShapeLayer::onSelectionChanged()
+{
+    if (d_ptr->promotedItem && !d_ptr->promotedItem->isSelected()) {
+        demote();
+    }
+}
+
+} // namespace Graphics
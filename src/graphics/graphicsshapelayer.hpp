@@ -0,0 +1,88 @@
+#pragma once
+
+#include "graphicsbasicitem.h"
+#include "graphicscircleitem.h"
+#include "graphicsrotatedrectitem.h"
+
+#include <QGraphicsObject>
+
+namespace Graphics {
+
+// Draws large read-only overlays (detection boxes, contours) from one item. Geometry is kept in
+// flat arrays per shape type, painting is batched and culled against the exposed rect, and
+// picking goes through a uniform grid. Clicking a shape promotes it to an editable
+// GraphicsBasicItem child. Every edit is written back to the layer, and the item is
+// dropped once it loses selection or when the layer moves.
+class GRAPHICS_EXPORT GraphicsShapeLayer : public QGraphicsObject
+{
+    Q_OBJECT
+public:
+    enum { Type = UserType + 3 };
+
+    explicit GraphicsShapeLayer(QGraphicsItem *parent = nullptr);
+    ~GraphicsShapeLayer() override;
+
+    // Shapes are numbered in insertion order, each call returns the index of its first shape.
+    auto addRects(const QList<QRectF> &rects) -> int;
+    auto addRotatedRects(const QList<RotatedRect> &rotatedRects) -> int;
+    auto addCircles(const QList<Circle> &circles) -> int;
+    auto addPolygons(const QList<QPolygonF> &polygons) -> int;
+    void clear();
+
+    [[nodiscard]] auto count() const -> int;
+    [[nodiscard]] auto shapeType(int index) const -> GraphicsBasicItem::Shape;
+    [[nodiscard]] auto shapeBoundingRect(int index) const -> QRectF;
+
+    // Only valid for shapes of the matching type.
+    [[nodiscard]] auto rect(int index) const -> QRectF;
+    [[nodiscard]] auto rotatedRect(int index) const -> RotatedRect;
+    [[nodiscard]] auto circle(int index) const -> Circle;
+    [[nodiscard]] auto polygon(int index) const -> QPolygonF;
+
+    void setPen(const QPen &pen);
+    [[nodiscard]] auto pen() const -> QPen;
+
+    void setBrush(const QBrush &brush);
+    [[nodiscard]] auto brush() const -> QBrush;
+
+    // Pick tolerance, also applied to promoted items, see GraphicsBasicItem::setMargin().
+    void setMargin(double margin);
+    [[nodiscard]] auto margin() const -> double;
+
+    // The topmost shape at pos, -1 if there is none. Promoted shapes are skipped.
+    [[nodiscard]] auto shapeAt(const QPointF &pos) const -> int;
+    [[nodiscard]] auto shapesIn(const QRectF &rect) const -> QList<int>;
+
+    // Hides the shape from the layer and shows it as a selected editable item instead.
+    // The item works in scene coordinates like other GraphicsBasicItems, shapes are mapped
+    // through the layer's scene transform. Returns nullptr if the geometry is rejected by
+    // the item, or if the transform rotates a rect or scales a rotated rect or circle
+    // unevenly.
+    auto promote(int index) -> GraphicsBasicItem *;
+    void demote();
+    [[nodiscard]] auto promotedItem() const -> GraphicsBasicItem *;
+    [[nodiscard]] auto promotedIndex() const -> int;
+
+    [[nodiscard]] auto type() const -> int override { return Type; }
+    [[nodiscard]] auto boundingRect() const -> QRectF override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+signals:
+    void shapePromoted(int index, Graphics::GraphicsBasicItem *item);
+    void shapeDemoted(int index);
+
+protected:
+    void mousePressEvent(QGraphicsSceneMouseEvent *event) override;
+    auto itemChange(GraphicsItemChange change, const QVariant &value) -> QVariant override;
+
+private:
+    void onSelectionChanged();
+    void onChildrenChanged();
+    void onPromotedGeometryChanged(GraphicsBasicItem *item);
+    void releasePromotion();
+
+    class GraphicsShapeLayerPrivate;
+    QScopedPointer<GraphicsShapeLayerPrivate> d_ptr;
+};
+
+} // namespace Graphics
@@ -0,0 +1,214 @@
+#include "graphicstiledimageitem.hpp"
+#include "tiledimage.hpp"
+
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QWidget>
+
+#include <algorithm>
+#include <cmath>
+
+namespace Graphics {
+
+class GraphicsTiledImageItem::GraphicsTiledImageItemPrivate
+{
+public:
+    explicit GraphicsTiledImageItemPrivate(GraphicsTiledImageItem *q)
+        : q_ptr(q)
+    {}
+
+    // 某一层的一个像素对应原图的像素数
+    [[nodiscard]] auto levelScale(int level) const -> QPointF
+    {
+        const auto size = tiledImage->size();
+        const auto levelSize = tiledImage->levelSize(level);
+        return {static_cast<qreal>(size.width()) / levelSize.width(),
+                static_cast<qreal>(size.height()) / levelSize.height()};
+    }
+
+    [[nodiscard]] auto itemRect(int level, const QRect &rect) const -> QRectF
+    {
+        const auto scale = levelScale(level);
+        return {rect.x() * scale.x(),
+                rect.y() * scale.y(),
+                rect.width() * scale.x(),
+                rect.height() * scale.y()};
+    }
+
+    // item 坐标中的区域覆盖的 tile 行列范围
+    [[nodiscard]] auto tileRange(int level, const QRectF &rect) const -> QRect
+    {
+        const auto scale = levelScale(level);
+        const auto count = tiledImage->tileCount(level);
+        const auto tileWidth = TiledImage::TileSize * scale.x();
+        const auto tileHeight = TiledImage::TileSize * scale.y();
+        const auto left = static_cast<int>(std::floor(rect.left() / tileWidth));
+        const auto top = static_cast<int>(std::floor(rect.top() / tileHeight));
+        const auto right = static_cast<int>(std::ceil(rect.right() / tileWidth)) - 1;
+        const auto bottom = static_cast<int>(std::ceil(rect.bottom() / tileHeight)) - 1;
+        return QRect(QPoint(qBound(0, left, count.width() - 1), qBound(0, top, count.height() - 1)),
+                     QPoint(qBound(0, right, count.width() - 1),
+                            qBound(0, bottom, count.height() - 1)));
+    }
+
+    // 视口变化后丢弃排队中的旧请求，离视口中心近的 tile 先解码
+    void requestTiles(int level, const QRect &range)
+    {
+        if (level != requestedLevel || range != requestedRange) {
+            tiledImage->cancelPending();
+            requestedLevel = level;
+            requestedRange = range;
+        }
+
+        QImage image;
+        tiledImage->tile(tiledImage->levelCount() - 1, 0, 0, image);
+
+        QList<QPoint> tiles;
+        tiles.reserve(range.width() * range.height());
+        for (int row = range.top(); row <= range.bottom(); ++row) {
+            for (int column = range.left(); column <= range.right(); ++column) {
+                tiles.append({column, row});
+            }
+        }
+        const auto center = QRectF(range).center();
+        std::sort(tiles.begin(), tiles.end(), [&center](const QPoint &lhs, const QPoint &rhs) {
+            const auto lhsOffset = QPointF(lhs) - center;
+            const auto rhsOffset = QPointF(rhs) - center;
+            return QPointF::dotProduct(lhsOffset, lhsOffset)
+                   < QPointF::dotProduct(rhsOffset, rhsOffset);
+        });
+        for (const auto &tile : std::as_const(tiles)) {
+            tiledImage->tile(level, tile.x(), tile.y(), image);
+        }
+    }
+
+    void drawTile(QPainter *painter, int level, int column, int row)
+    {
+        const auto target = itemRect(level, tiledImage->tileRect(level, column, row));
+        QImage image;
+        if (tiledImage->tile(level, column, row, image, false)) {
+            painter->drawImage(target, image);
+            return;
+        }
+
+        // 还没解码时用已有的更粗一层的 tile 占位
+        for (int coarse = level + 1; coarse < tiledImage->levelCount(); ++coarse) {
+            const auto shift = coarse - level;
+            const auto coarseColumn = column >> shift;
+            const auto coarseRow = row >> shift;
+            if (!tiledImage->tile(coarse, coarseColumn, coarseRow, image, false)) {
+                continue;
+            }
+            const auto scale = levelScale(coarse);
+            const auto origin = tiledImage->tileRect(coarse, coarseColumn, coarseRow).topLeft();
+            const QRectF source(target.x() / scale.x() - origin.x(),
+                                target.y() / scale.y() - origin.y(),
+                                target.width() / scale.x(),
+                                target.height() / scale.y());
+            painter->drawImage(target, image, source);
+            return;
+        }
+    }
+
+    GraphicsTiledImageItem *q_ptr;
+
+    TiledImage *tiledImage = nullptr;
+    int requestedLevel = -1;
+    QRect requestedRange;
+};
+
+GraphicsTiledImageItem::GraphicsTiledImageItem(const QString &fileName, QGraphicsItem *parent)
+    : QGraphicsObject(parent)
+    , d_ptr(new GraphicsTiledImageItemPrivate(this))
+{
+    setFlag(ItemUsesExtendedStyleOption);
+    d_ptr->tiledImage = new TiledImage(fileName, this);
+    connect(d_ptr->tiledImage,
+            &TiledImage::tileLoaded,
+            this,
+            &GraphicsTiledImageItem::onTileLoaded);
+}
+
+GraphicsTiledImageItem::~GraphicsTiledImageItem() = default;
+
+auto GraphicsTiledImageItem::tiledImage() const -> TiledImage *
+{
+    return d_ptr->tiledImage;
+}
+
+auto GraphicsTiledImageItem::imageSize() const -> QSize
+{
+    return d_ptr->tiledImage->size();
+}
+
+auto GraphicsTiledImageItem::pixel(const QPointF &pos, QRgb &rgb) const -> bool
+{
+    if (!boundingRect().contains(pos)) {
+        return false;
+    }
+
+    QImage image;
+    for (int level = 0; level < d_ptr->tiledImage->levelCount(); ++level) {
+        const auto scale = d_ptr->levelScale(level);
+        const QPoint point(static_cast<int>(pos.x() / scale.x()),
+                           static_cast<int>(pos.y() / scale.y()));
+        const auto column = point.x() / TiledImage::TileSize;
+        const auto row = point.y() / TiledImage::TileSize;
+        if (!d_ptr->tiledImage->tile(level, column, row, image, false)) {
+            continue;
+        }
+        const auto local = point - d_ptr->tiledImage->tileRect(level, column, row).topLeft();
+        if (image.rect().contains(local)) {
+            rgb = image.pixel(local);
+            return true;
+        }
+    }
+    return false;
+}
+
+auto GraphicsTiledImageItem::boundingRect() const -> QRectF
+{
+    return QRectF(QPointF(0, 0), imageSize());
+}
+
+void GraphicsTiledImageItem::paint(QPainter *painter,
+                                   const QStyleOptionGraphicsItem *option,
+                                   QWidget *widget)
+{
+    if (!d_ptr->tiledImage->isValid()) {
+        return;
+    }
+
+    const auto transform = painter->worldTransform();
+    const auto scale = QStyleOptionGraphicsItem::levelOfDetailFromTransform(transform)
+                       * painter->device()->devicePixelRatioF();
+    const auto level = d_ptr->tiledImage->levelForScale(scale);
+
+    // 按整个视口请求 tile，exposedRect 可能只是局部刷新的区域
+    auto visibleRect = option->exposedRect;
+    if (widget) {
+        visibleRect = transform.inverted().mapRect(QRectF(widget->rect()));
+    }
+    visibleRect &= boundingRect();
+    if (!visibleRect.isEmpty()) {
+        d_ptr->requestTiles(level, d_ptr->tileRange(level, visibleRect));
+    }
+
+    const auto exposedRect = option->exposedRect & boundingRect();
+    if (exposedRect.isEmpty()) {
+        return;
+    }
+    const auto range = d_ptr->tileRange(level, exposedRect);
+    for (int row = range.top(); row <= range.bottom(); ++row) {
+        for (int column = range.left(); column <= range.right(); ++column) {
+            d_ptr->drawTile(painter, level, column, row);
+        }
+    }
+}
+
+void GraphicsTiledImageItem::onTileLoaded(int level, int column, int row)
+{
+    update(d_ptr->itemRect(level, d_ptr->tiledImage->tileRect(level, column, row)));
+}
+
+} // namespace Graphics
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "graphics_global.h"
+
+#include <QGraphicsObject>
+
+namespace Graphics {
+
+class TiledImage;
+// Paints a TiledImage in full resolution item coordinates, only the tiles in view are
+// drawn and decoded at the level matching the current zoom. Coarser levels stand in
+// while finer tiles are still loading.
+class GRAPHICS_EXPORT GraphicsTiledImageItem : public QGraphicsObject
+{
+    Q_OBJECT
+public:
+    enum { Type = UserType + 2 };
+
+    explicit GraphicsTiledImageItem(const QString &fileName, QGraphicsItem *parent = nullptr);
+    ~GraphicsTiledImageItem() override;
+
+    [[nodiscard]] auto tiledImage() const -> TiledImage *;
+    [[nodiscard]] auto imageSize() const -> QSize;
+
+    // Reads from the finest tile that is already decoded, does not block.
+    auto pixel(const QPointF &pos, QRgb &rgb) const -> bool;
+
+    [[nodiscard]] auto type() const -> int override { return Type; }
+    [[nodiscard]] auto boundingRect() const -> QRectF override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private:
+    void onTileLoaded(int level, int column, int row);
+
+    class GraphicsTiledImageItemPrivate;
+    QScopedPointer<GraphicsTiledImageItemPrivate> d_ptr;
+};
+
+} // namespace Graphics
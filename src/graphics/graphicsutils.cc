@@ -4,8 +4,30 @@
 #include <QPainterPath>
 #include <QtMath>
 
+#include <algorithm>
+#include <utility>
+
 namespace Graphics::Utils {
 
+namespace {
+
+auto segmentDistanceSquared(const QPointF &point, const QPointF &a, const QPointF &b) -> double
+{
+    const QPointF lineVec = b - a;
+    const QPointF pointVec = point - a;
+    const double lineLengthSquared = QPointF::dotProduct(lineVec, lineVec);
+    if (qFuzzyIsNull(lineLengthSquared)) {
+        return QPointF::dotProduct(pointVec, pointVec);
+    }
+    const double t = std::clamp(QPointF::dotProduct(pointVec, lineVec) / lineLengthSquared,
+                                0.0,
+                                1.0);
+    const QPointF offset = pointVec - t * lineVec;
+    return QPointF::dotProduct(offset, offset);
+}
+
+} // namespace
+
 auto calculateCircle(const QPolygonF &pts, QPointF &center, double &radius) -> bool
 {
     // 输入验证
@@ -343,6 +365,63 @@ auto isPointNearEdge(const QPointF &point, const QLineF &line, double margin) ->
     return distance(point, projection) <= margin;
 }
 
+auto simplifyPolygon(const QPolygonF &ply, double tolerance) -> QPolygonF
+{
+    const auto size = ply.size();
+    if (size <= 3 || tolerance <= 0) {
+        return ply;
+    }
+
+    // 闭合多边形先固定第一个点和离它最远的点，分成两条折线分别抽稀
+    qsizetype farthest = 0;
+    double farthestDistance = 0;
+    for (qsizetype i = 1; i < size; ++i) {
+        const QPointF offset = ply[i] - ply[0];
+        const double distanceSquared = QPointF::dotProduct(offset, offset);
+        if (distanceSquared > farthestDistance) {
+            farthestDistance = distanceSquared;
+            farthest = i;
+        }
+    }
+    if (farthest == 0) {
+        return ply;
+    }
+
+    // 用栈代替递归，几万个点的轮廓也不会栈溢出；下标 size 表示回到第一个点
+    const double toleranceSquared = tolerance * tolerance;
+    QList<bool> keep(size, false);
+    keep[0] = keep[farthest] = true;
+    QList<std::pair<qsizetype, qsizetype>> ranges{{0, farthest}, {farthest, size}};
+    while (!ranges.isEmpty()) {
+        const auto [first, last] = ranges.takeLast();
+        const auto &a = ply[first];
+        const auto &b = ply[last % size];
+        qsizetype index = -1;
+        double maxDistance = toleranceSquared;
+        for (qsizetype i = first + 1; i < last; ++i) {
+            const double distanceSquared = segmentDistanceSquared(ply[i], a, b);
+            if (distanceSquared > maxDistance) {
+                maxDistance = distanceSquared;
+                index = i;
+            }
+        }
+        if (index < 0) {
+            continue;
+        }
+        keep[index] = true;
+        ranges.append({first, index});
+        ranges.append({index, last});
+    }
+
+    QPolygonF simplified;
+    for (qsizetype i = 0; i < size; ++i) {
+        if (keep[i]) {
+            simplified.append(ply[i]);
+        }
+    }
+    return simplified;
+}
+
 auto pointAtDistance(const QPointF &from, const QPointF &to, double distance) -> QPointF
 {
     QLineF line(from, to);
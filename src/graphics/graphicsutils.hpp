@@ -32,6 +32,9 @@ auto calculateAllArc(const QPolygonF &ply, QPainterPath &path, const double marg
 
 auto isPointNearEdge(const QPointF &point, const QLineF &line, double margin) -> bool;
 
+// 闭合多边形的 Douglas-Peucker 抽稀，去掉的顶点离保留下来的边都不超过 tolerance
+auto simplifyPolygon(const QPolygonF &ply, double tolerance) -> QPolygonF;
+
 } // namespace Utils
 
 } // namespace Graphics
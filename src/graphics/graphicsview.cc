@@ -1,12 +1,100 @@
 #include "graphicsview.hpp"
+#include "animationplayer.hpp"
 #include "graphicspixmapitem.h"
+#include "graphicstiledimageitem.hpp"
+#include "tiledimage.hpp"
 
 #include <utils/imagecache.hpp>
 
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLWidget>
 #include <QtWidgets>
 
 namespace Graphics {
 
+// 超过解码内存上限或者常见的最大纹理尺寸时改用分块显示
+static auto needsTiling(const QSize &size) -> bool
+{
+    const auto bytes = static_cast<qint64>(size.width()) * size.height() * 4;
+    const auto limit = static_cast<qint64>(QImageReader::allocationLimit()) * 1024 * 1024;
+    return qMax(size.width(), size.height()) > 16384 || (limit > 0 && bytes > limit);
+}
+
+// 软件渲染器（如 llvmpipe）也能创建上下文，只有完全没有 OpenGL 时才退回光栅
+static auto openGLAvailable() -> bool
+{
+    static const auto available = [] {
+        QOpenGLContext context;
+        if (!context.create()) {
+            return false;
+        }
+        QOffscreenSurface surface;
+        surface.setFormat(context.format());
+        surface.create();
+        if (!context.makeCurrent(&surface)) {
+            return false;
+        }
+        context.doneCurrent();
+        return true;
+    }();
+    return available;
+}
+
+static auto rgbText(int red, int green, int blue) -> QString
+{
+    return QString("%1 %2 %3").arg(red).arg(green).arg(blue);
+}
+
+static auto rgbText(qreal red, qreal green, qreal blue) -> QString
+{
+    return QString("%1 %2 %3")
+        .arg(QString::number(red, 'g', 4),
+             QString::number(green, 'g', 4),
+             QString::number(blue, 'g', 4));
+}
+
+// 按图像的原始位深显示像素值，16 位为 0-65535，浮点格式显示浮点数
+static auto pixelText(const QImage &image, const QPoint &pos) -> QString
+{
+    if (!image.valid(pos)) {
+        return {};
+    }
+    const auto *line = image.constScanLine(pos.y());
+    const auto premultiplied = image.pixelFormat().premultiplied()
+                               == QPixelFormat::Premultiplied;
+    auto floatText = [premultiplied](const auto *pixel) {
+        const float alpha = pixel[3];
+        const auto factor = premultiplied && alpha > 0 ? 1.0 / alpha : 1.0;
+        return rgbText(pixel[0] * factor, pixel[1] * factor, pixel[2] * factor);
+    };
+    switch (image.format()) {
+    case QImage::Format_Grayscale8: return QString::number(line[pos.x()]);
+    case QImage::Format_Grayscale16:
+        return QString::number(reinterpret_cast<const quint16 *>(line)[pos.x()]);
+    case QImage::Format_RGBX64:
+    case QImage::Format_RGBA64:
+    case QImage::Format_RGBA64_Premultiplied: {
+        auto rgba64 = reinterpret_cast<const QRgba64 *>(line)[pos.x()];
+        if (premultiplied) {
+            rgba64 = rgba64.unpremultiplied();
+        }
+        return rgbText(rgba64.red(), rgba64.green(), rgba64.blue());
+    }
+    case QImage::Format_RGBX16FPx4:
+    case QImage::Format_RGBA16FPx4:
+    case QImage::Format_RGBA16FPx4_Premultiplied:
+        return floatText(reinterpret_cast<const qfloat16 *>(line) + pos.x() * 4);
+    case QImage::Format_RGBX32FPx4:
+    case QImage::Format_RGBA32FPx4:
+    case QImage::Format_RGBA32FPx4_Premultiplied:
+        return floatText(reinterpret_cast<const float *>(line) + pos.x() * 4);
+    default: break;
+    }
+    const auto rgb = image.pixel(pos);
+    return rgbText(qRed(rgb), qGreen(rgb), qBlue(rgb));
+}
+
 class GraphicsView::ImageViewPrivate
 {
 public:
@@ -35,6 +123,15 @@ public:
 
     ~ImageViewPrivate() {}
 
+    // 取色用的 CPU 端图像，保留解码时的位深，没有时才从 pixmap 转换一次
+    auto readoutImage() -> const QImage &
+    {
+        if (sourceImage.isNull()) {
+            sourceImage = pixmapItem->pixmap().toImage();
+        }
+        return sourceImage;
+    }
+
     GraphicsView *q_ptr;
 
     GraphicsPixmapItem *pixmapItem;
@@ -44,12 +141,63 @@ public:
     bool showOutline = false;
     bool showCrossLine = false;
     QString rgbInfo;
+    QImage sourceImage;
     QPointF mousePoint;
     QScopedPointer<QMenu> menu;
 
     const qreal scaleFactor = 1.2;
 
-    QScopedPointer<QMovie> movie;
+    // 动图逐帧只替换 pixmap 内容，场景、遮罩和缩放在第一帧时设置
+    QScopedPointer<AnimationPlayer> animationPlayer;
+    bool animationShown = false;
+    quint64 loadSerial = 0;
+
+    // 从文件加载时可能先显示降采样的预览图，放大后再换成原图
+    QString sourceUrl;
+    // 最近一次请求的文件，显示出来之前 pixmap() 也按它返回原图
+    QString requestedUrl;
+    bool fullResolutionRequested = false;
+
+    // 超大图像按金字塔分块显示，此时 pixmapItem 隐藏
+    QPointer<GraphicsTiledImageItem> tiledItem;
+
+    void resetMotion()
+    {
+        pendingZoom = 1.0;
+        pendingPan = QPointF();
+        panVelocity = QPointF();
+    }
+
+    // 记录两次绘制的间隔，停顿之后的第一帧不计入
+    void recordFrame()
+    {
+        if (paintClock.isValid() && paintClock.elapsed() < 250) {
+            frameTimes.append(paintClock.nsecsElapsed() / 1e6);
+            if (frameTimes.size() > 120) {
+                frameTimes.removeFirst();
+            }
+        }
+        paintClock.start();
+    }
+
+    static constexpr qreal zoomTimeConstant = 40.0;      // 毫秒
+    static constexpr qreal momentumTimeConstant = 250.0; // 毫秒
+    static constexpr qreal minimumMomentum = 20.0;       // 像素/秒
+
+    // 滚轮和拖动的输入先累积，按屏幕刷新率每帧应用一次变换
+    QTimer *frameTimer = nullptr;
+    QElapsedTimer frameClock;
+    qreal pendingZoom = 1.0;
+    QPointF zoomAnchor;
+    QPointF pendingPan;
+    QPointF panVelocity; // 像素/秒，松开中键后继续移动
+    bool panning = false;
+    QPointF lastPanPos;
+    QElapsedTimer panClock;
+
+    bool showFrameRate = false;
+    QElapsedTimer paintClock;
+    QList<qreal> frameTimes; // 毫秒
 };
 
 GraphicsView::GraphicsView(QWidget *parent)
@@ -72,6 +220,13 @@ GraphicsView::~GraphicsView() {}
 
 auto GraphicsView::pixmap() const -> QPixmap
 {
+    // 预览图、分块显示或者还在加载时从文件解码原图，阻塞到解码完成
+    if (!d_ptr->requestedUrl.isEmpty()
+        && (d_ptr->sourceUrl != d_ptr->requestedUrl || isPreviewing())) {
+        QImage image;
+        Utils::ImageCache::instance()->find(d_ptr->requestedUrl, image);
+        return QPixmap::fromImage(image);
+    }
     return d_ptr->pixmapItem->pixmap();
 }
 
@@ -106,46 +261,58 @@ void GraphicsView::setPixmap(const QPixmap &pixmap)
         return;
     }
 
-    d_ptr->pixmapItem->setSourcePixmap(pixmap);
-    auto rectF = d_ptr->pixmapItem->boundingRect();
-    d_ptr->backgroundItem->setRect(rectF);
-    d_ptr->outlineItem->setRect(rectF);
-
-    scene()->setSceneRect(rectF);
-    resetToOriginalSize();
-
-    if (pixmap.size().width() > width() || pixmap.size().height() > height()) {
-        fitToScreen();
-    }
-
-    emit imageSizeChanged(pixmap.size());
+    ++d_ptr->loadSerial;
+    d_ptr->animationPlayer.reset();
+    d_ptr->sourceUrl.clear();
+    d_ptr->requestedUrl.clear();
+    showPixmap(pixmap, pixmap.size());
 }
 
 void GraphicsView::setImagerReader(QImageReader &imageReader)
 {
+    const auto serial = ++d_ptr->loadSerial;
+    d_ptr->animationPlayer.reset();
     if (!imageReader.supportsAnimation()) {
-        d_ptr->movie.reset();
-        QImage image;
-        if (!Utils::ImageCache::instance()->find(imageReader.fileName(), image)) {
-            QMessageBox::warning(this,
-                                 tr("WARNING"),
-                                 tr("Picture failed to open, Url: %1!").arg(imageReader.fileName()));
+        const auto fileName = imageReader.fileName();
+        const auto imageSize = imageReader.size();
+        d_ptr->requestedUrl = fileName;
+        if (needsTiling(imageSize) && TiledImage::canTile(imageReader)) {
+            showTiledImage(fileName);
             return;
         }
-        setPixmap(QPixmap::fromImage(image));
+        // 先按屏幕大小解码，放大时再加载原图
+        const auto screenSize = screen()->size() * screen()->devicePixelRatio();
+        const auto maxDimension = qMax(screenSize.width(), screenSize.height());
+        Utils::ImageCache::instance()->findAsync(
+            fileName, maxDimension, this, [=, this](const QImage &image) {
+                if (serial != d_ptr->loadSerial) {
+                    return; // 已经有更新的请求
+                }
+                if (image.isNull()) {
+                    QMessageBox::warning(this,
+                                         tr("WARNING"),
+                                         tr("Picture failed to open, Url: %1!").arg(fileName));
+                    return;
+                }
+                d_ptr->sourceUrl = fileName;
+                d_ptr->fullResolutionRequested = false;
+                showPixmap(QPixmap::fromImage(image),
+                           imageSize.isValid() ? imageSize : image.size());
+                d_ptr->sourceImage = image;
+            });
         return;
     }
 
-    d_ptr->movie.reset(new QMovie(imageReader.fileName()));
-    if (!d_ptr->movie->isValid()) {
-        qWarning() << d_ptr->movie->lastError() << d_ptr->movie->lastErrorString();
-    }
-    connect(d_ptr->movie.data(),
-            &QMovie::frameChanged,
+    d_ptr->sourceUrl.clear();
+    d_ptr->requestedUrl.clear();
+    d_ptr->animationPlayer.reset(new AnimationPlayer);
+    d_ptr->animationShown = false;
+    connect(d_ptr->animationPlayer.data(),
+            &AnimationPlayer::frameChanged,
             this,
-            &GraphicsView::onMovieFrameChanged,
-            Qt::UniqueConnection);
-    d_ptr->movie->start();
+            &GraphicsView::onAnimationFrameChanged);
+    d_ptr->animationPlayer->setFileName(imageReader.fileName());
+    d_ptr->animationPlayer->start();
 }
 
 void GraphicsView::setViewBackground(bool enable)
@@ -168,6 +335,38 @@ void GraphicsView::setViewCrossLine(bool enable)
     }
 }
 
+void GraphicsView::setViewFrameRate(bool enable)
+{
+    d_ptr->showFrameRate = enable;
+    d_ptr->frameTimes.clear();
+    d_ptr->paintClock.invalidate();
+    viewport()->update();
+}
+
+void GraphicsView::setHardwareAcceleration(bool enable)
+{
+    if (enable == isHardwareAccelerated()) {
+        return;
+    }
+    if (enable && !openGLAvailable()) {
+        qWarning() << "OpenGL is not available, keep using the raster viewport";
+        return;
+    }
+    if (enable) {
+        setViewport(new QOpenGLWidget);
+        // OpenGL 每帧都重绘整个缓冲区，局部更新没有意义
+        setViewportUpdateMode(FullViewportUpdate);
+    } else {
+        setViewport(new QWidget);
+        setViewportUpdateMode(SmartViewportUpdate);
+    }
+}
+
+auto GraphicsView::isHardwareAccelerated() const -> bool
+{
+    return qobject_cast<QOpenGLWidget *>(viewport()) != nullptr;
+}
+
 void GraphicsView::zoomIn()
 {
     doScale(d_ptr->scaleFactor);
@@ -186,7 +385,7 @@ void GraphicsView::resetToOriginalSize()
 
 void GraphicsView::fitToScreen()
 {
-    fitInView(d_ptr->pixmapItem, Qt::KeepAspectRatio);
+    fitInView(imageItem(), Qt::KeepAspectRatio);
     emitScaleFactor();
 }
 
@@ -200,11 +399,30 @@ void GraphicsView::anti_rotateNinetieth()
     rotate(-90);
 }
 
-void GraphicsView::onMovieFrameChanged(int frameNumber)
+auto GraphicsView::animationPlayer() const -> AnimationPlayer *
+{
+    return d_ptr->animationPlayer.data();
+}
+
+void GraphicsView::onAnimationFrameChanged(const QImage &frame)
 {
-    Q_UNUSED(frameNumber)
-    //qDebug() << frameNumber;
-    setPixmap(d_ptr->movie->currentPixmap());
+    auto pixmap = QPixmap::fromImage(frame);
+    if (!d_ptr->animationShown || d_ptr->pixmapItem->pixmap().size() != frame.size()) {
+        d_ptr->animationShown = true;
+        showPixmap(pixmap, frame.size());
+    } else {
+        // 只替换帧内容，不重置遮罩、场景和缩放，也不发出 imageSizeChanged
+        d_ptr->pixmapItem->setPixmap(pixmap);
+    }
+    d_ptr->sourceImage = frame;
+
+    if (d_ptr->showCrossLine) {
+        const auto info = pixelInfo(mapToScene(d_ptr->mousePoint.toPoint()));
+        if (!info.isEmpty() && info != d_ptr->rgbInfo) {
+            d_ptr->rgbInfo = info;
+            viewport()->update(overlayRegion());
+        }
+    }
 }
 
 void GraphicsView::drawBackground(QPainter *p, const QRectF &)
@@ -226,6 +444,10 @@ void GraphicsView::drawForeground(QPainter *painter, const QRectF &rect)
         drawInfo(painter);
         drawCrossLine(painter);
     }
+    if (d_ptr->showFrameRate) {
+        d_ptr->recordFrame();
+        drawFrameRate(painter);
+    }
 
     painter->restore();
 }
@@ -233,32 +455,78 @@ void GraphicsView::drawForeground(QPainter *painter, const QRectF &rect)
 void GraphicsView::wheelEvent(QWheelEvent *event)
 {
     QGraphicsView::wheelEvent(event);
-    if (d_ptr->pixmapItem->pixmap().isNull()) {
+    if (d_ptr->pixmapItem->pixmap().isNull() && !d_ptr->tiledItem) {
         return;
     }
-    qreal factor = qPow(d_ptr->scaleFactor, event->angleDelta().y() / 240.0);
-    doScale(factor);
+    // 触摸板每秒会发送上百次滚轮事件，先累积起来，每帧只变换一次
+    d_ptr->pendingZoom *= qPow(d_ptr->scaleFactor, event->angleDelta().y() / 240.0);
+    d_ptr->zoomAnchor = event->position();
+    scheduleFrame();
+}
+
+void GraphicsView::mousePressEvent(QMouseEvent *event)
+{
+    // 预览上不能编辑遮罩，先同步加载原图，这一笔直接画在原图上，不会丢失
+    if (event->button() == Qt::LeftButton && isPreviewing()
+        && d_ptr->pixmapItem->maskEditingMode() != GraphicsPixmapItem::MaskEditingMode::Normal) {
+        QImage image;
+        if (Utils::ImageCache::instance()->find(d_ptr->sourceUrl, image)) {
+            showFullResolution(image);
+        }
+    }
+    if (event->button() != Qt::MiddleButton) {
+        QGraphicsView::mousePressEvent(event);
+        return;
+    }
+    d_ptr->panning = true;
+    d_ptr->panVelocity = QPointF();
+    d_ptr->lastPanPos = event->position();
+    d_ptr->panClock.start();
+    viewport()->setCursor(Qt::ClosedHandCursor);
+    event->accept();
 }
 
 void GraphicsView::mouseMoveEvent(QMouseEvent *event)
 {
     QGraphicsView::mouseMoveEvent(event);
+    if (d_ptr->panning) {
+        const auto pos = event->position();
+        const auto delta = pos - d_ptr->lastPanPos;
+        const auto elapsed = qMax<qint64>(d_ptr->panClock.restart(), 1);
+        d_ptr->lastPanPos = pos;
+        d_ptr->pendingPan += delta;
+        // 平滑最近的拖动速度，作为松开后惯性移动的初速度
+        d_ptr->panVelocity = d_ptr->panVelocity * 0.2 + delta * (800.0 / elapsed);
+        scheduleFrame();
+    }
     if (!d_ptr->showCrossLine || !d_ptr->pixmapItem) {
         return;
     }
-    QPointF pointF = mapToScene(event->pos());
+    // 只重绘十字线和信息框移动前后占据的区域
+    auto dirtyRegion = overlayRegion();
     d_ptr->mousePoint = event->pos();
-    if (!d_ptr->pixmapItem->contains(pointF)) {
+    const auto info = pixelInfo(mapToScene(event->pos()));
+    if (!info.isEmpty()) {
+        d_ptr->rgbInfo = info;
+    }
+    dirtyRegion += overlayRegion();
+    viewport()->update(dirtyRegion);
+}
+
+void GraphicsView::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::MiddleButton || !d_ptr->panning) {
+        QGraphicsView::mouseReleaseEvent(event);
         return;
     }
-    QRgb rgb = d_ptr->pixmapItem->pixmap().toImage().pixel(pointF.toPoint());
-    d_ptr->rgbInfo = QString("( %1, %2 ) | %3 %4 %5")
-                         .arg(QString::number(pointF.x()),
-                              QString::number(pointF.y()),
-                              QString::number(qRed(rgb)),
-                              QString::number(qGreen(rgb)),
-                              QString::number(qBlue(rgb)));
-    scene()->update();
+    d_ptr->panning = false;
+    // 停住一会儿再松开时不需要惯性
+    if (d_ptr->panClock.elapsed() > 100) {
+        d_ptr->panVelocity = QPointF();
+    }
+    scheduleFrame();
+    viewport()->unsetCursor();
+    event->accept();
 }
 
 void GraphicsView::mouseDoubleClickEvent(QMouseEvent *event)
@@ -304,6 +572,11 @@ void GraphicsView::initializeView()
     setCursor(Qt::CrossCursor);
     setMouseTracking(true);
     setAcceptDrops(true);
+
+    d_ptr->frameTimer = new QTimer(this);
+    d_ptr->frameTimer->setTimerType(Qt::PreciseTimer);
+    connect(d_ptr->frameTimer, &QTimer::timeout, this, &GraphicsView::onFrameTick);
+
     initScene();
     createPopMenu();
 }
@@ -348,6 +621,19 @@ void GraphicsView::createPopMenu()
     d_ptr->menu->addAction(showBackgroundAction);
     d_ptr->menu->addAction(showOutlineAction);
     d_ptr->menu->addAction(showCrossLineAction);
+    QAction *showFrameRateAction = new QAction(tr("Show Frame Rate"), this);
+    showFrameRateAction->setCheckable(true);
+    connect(showFrameRateAction, &QAction::triggered, this, &GraphicsView::setViewFrameRate);
+    d_ptr->menu->addAction(showFrameRateAction);
+    d_ptr->menu->addSeparator();
+
+    QAction *hardwareAccelerationAction = new QAction(tr("Hardware Acceleration"), this);
+    hardwareAccelerationAction->setCheckable(true);
+    connect(hardwareAccelerationAction, &QAction::triggered, this, [=, this](bool checked) {
+        setHardwareAcceleration(checked);
+        hardwareAccelerationAction->setChecked(isHardwareAccelerated());
+    });
+    d_ptr->menu->addAction(hardwareAccelerationAction);
 }
 
 auto GraphicsView::textRect(const Qt::Corner pos, const QFontMetrics &metrics, const QString &text)
@@ -370,18 +656,14 @@ auto GraphicsView::textRect(const Qt::Corner pos, const QFontMetrics &metrics, c
     return QRect(startX, startY, rectWidth, rectHeight);
 }
 
-void GraphicsView::drawInfo(QPainter *painter)
+void GraphicsView::drawTextBox(QPainter *painter, Qt::Corner corner, const QString &text)
 {
-    if (d_ptr->rgbInfo.isEmpty()) {
-        return;
-    }
-    QFont font;
-    font.setPixelSize(height() / 30);
+    const auto font = infoFont();
     painter->setFont(font);
     QFontMetrics metrics(font);
     int marginX = 5;
     int marginY = metrics.leading() + metrics.ascent() + 2;
-    QRect rect = textRect(Qt::TopLeftCorner, metrics, d_ptr->rgbInfo);
+    QRect rect = textRect(corner, metrics, text);
     QPoint textPos = QPoint(rect.x() + marginX, rect.y() + marginY);
 
     painter->setPen(Qt::NoPen);
@@ -390,7 +672,75 @@ void GraphicsView::drawInfo(QPainter *painter)
     painter->setBrush(bgColor);
     painter->drawRect(rect);
     painter->setPen(QColor(83, 209, 255));
-    painter->drawText(textPos, d_ptr->rgbInfo);
+    painter->drawText(textPos, text);
+}
+
+void GraphicsView::drawInfo(QPainter *painter)
+{
+    if (d_ptr->rgbInfo.isEmpty()) {
+        return;
+    }
+    drawTextBox(painter, Qt::TopLeftCorner, d_ptr->rgbInfo);
+}
+
+void GraphicsView::drawFrameRate(QPainter *painter)
+{
+    const auto &frameTimes = d_ptr->frameTimes;
+    if (frameTimes.isEmpty()) {
+        return;
+    }
+    qreal total = 0;
+    qreal longest = 0;
+    for (const auto frameTime : frameTimes) {
+        total += frameTime;
+        longest = qMax(longest, frameTime);
+    }
+    const auto average = total / frameTimes.size();
+    drawTextBox(painter,
+                Qt::TopRightCorner,
+                tr("%1 fps | %2 ms | max %3 ms")
+                    .arg(QString::number(1000.0 / average, 'f', 1),
+                         QString::number(average, 'f', 1),
+                         QString::number(longest, 'f', 1)));
+}
+
+auto GraphicsView::infoFont() const -> QFont
+{
+    QFont font;
+    font.setPixelSize(height() / 30);
+    return font;
+}
+
+auto GraphicsView::overlayRegion() -> QRegion
+{
+    const auto point = d_ptr->mousePoint.toPoint();
+    // 线宽小于 1，抗锯齿时会影响相邻像素
+    QRegion region(0, point.y() - 2, viewport()->width(), 5);
+    region += QRect(point.x() - 2, 0, 5, viewport()->height());
+    if (!d_ptr->rgbInfo.isEmpty()) {
+        region += textRect(Qt::TopLeftCorner, QFontMetrics(infoFont()), d_ptr->rgbInfo)
+                      .adjusted(-1, -1, 1, 1);
+    }
+    return region;
+}
+
+auto GraphicsView::pixelInfo(const QPointF &scenePos) -> QString
+{
+    QString value;
+    if (d_ptr->tiledItem) {
+        QRgb rgb = 0;
+        if (d_ptr->tiledItem->pixel(d_ptr->tiledItem->mapFromScene(scenePos), rgb)) {
+            value = rgbText(qRed(rgb), qGreen(rgb), qBlue(rgb));
+        }
+    } else {
+        const auto itemPoint = d_ptr->pixmapItem->mapFromScene(scenePos);
+        value = pixelText(d_ptr->readoutImage(), itemPoint.toPoint());
+    }
+    if (value.isEmpty()) {
+        return {};
+    }
+    return QString("( %1, %2 ) | %3")
+        .arg(QString::number(scenePos.x()), QString::number(scenePos.y()), value);
 }
 
 void GraphicsView::drawCrossLine(QPainter *painter)
@@ -411,6 +761,100 @@ void GraphicsView::emitScaleFactor()
     // get scale factor directly from the transform matrix
     qreal factor = transform().m11() * devicePixelRatioF();
     emit scaleFactorChanged(factor);
+    loadFullResolutionIfNeeded();
+}
+
+void GraphicsView::showPixmap(const QPixmap &pixmap, const QSize &sourceSize)
+{
+    d_ptr->resetMotion();
+    delete d_ptr->tiledItem;
+    d_ptr->sourceImage = QImage();
+    d_ptr->pixmapItem->setVisible(true);
+    d_ptr->pixmapItem->setSourcePixmap(pixmap);
+    d_ptr->pixmapItem->setScale(static_cast<qreal>(sourceSize.width()) / pixmap.width());
+    // 原图加载后会替换掉预览上的遮罩，预览时禁止编辑
+    d_ptr->pixmapItem->setMaskEditingEnabled(!isPreviewing());
+    auto rectF = d_ptr->pixmapItem->sceneBoundingRect();
+    d_ptr->backgroundItem->setRect(rectF);
+    d_ptr->outlineItem->setRect(rectF);
+
+    scene()->setSceneRect(rectF);
+    if (sourceSize.width() > width() || sourceSize.height() > height()) {
+        fitToScreen();
+    } else {
+        resetToOriginalSize();
+    }
+
+    emit imageSizeChanged(sourceSize);
+}
+
+void GraphicsView::showTiledImage(const QString &fileName)
+{
+    d_ptr->resetMotion();
+    delete d_ptr->tiledItem;
+    d_ptr->sourceUrl.clear();
+    d_ptr->pixmapItem->setVisible(false);
+    d_ptr->pixmapItem->setSourcePixmap(QPixmap());
+    d_ptr->pixmapItem->setScale(1.0);
+    d_ptr->sourceImage = QImage();
+    d_ptr->rgbInfo.clear();
+
+    d_ptr->tiledItem = new GraphicsTiledImageItem(fileName);
+    scene()->addItem(d_ptr->tiledItem);
+    const auto rectF = d_ptr->tiledItem->sceneBoundingRect();
+    d_ptr->backgroundItem->setRect(rectF);
+    d_ptr->outlineItem->setRect(rectF);
+
+    scene()->setSceneRect(rectF);
+    fitToScreen();
+
+    emit imageSizeChanged(d_ptr->tiledItem->imageSize());
+}
+
+auto GraphicsView::imageItem() const -> QGraphicsItem *
+{
+    if (d_ptr->tiledItem) {
+        return d_ptr->tiledItem;
+    }
+    return d_ptr->pixmapItem;
+}
+
+auto GraphicsView::isPreviewing() const -> bool
+{
+    return !d_ptr->sourceUrl.isEmpty() && d_ptr->pixmapItem->scale() > 1.0;
+}
+
+void GraphicsView::loadFullResolutionIfNeeded()
+{
+    if (!isPreviewing() || d_ptr->fullResolutionRequested) {
+        return;
+    }
+    // 预览图的一个像素在屏幕上超过一个像素时才需要原图
+    const auto matrix = transform();
+    const auto viewScale = qSqrt(matrix.m11() * matrix.m11() + matrix.m12() * matrix.m12())
+                           * devicePixelRatioF();
+    if (viewScale * d_ptr->pixmapItem->scale() <= 1.0) {
+        return;
+    }
+
+    d_ptr->fullResolutionRequested = true;
+    const auto serial = d_ptr->loadSerial;
+    const auto fileName = d_ptr->sourceUrl;
+    Utils::ImageCache::instance()->findAsync(fileName, this, [=, this](const QImage &image) {
+        // 开始编辑遮罩时可能已经同步加载了原图
+        if (serial != d_ptr->loadSerial || image.isNull() || !isPreviewing()) {
+            return;
+        }
+        showFullResolution(image);
+    });
+}
+
+void GraphicsView::showFullResolution(const QImage &image)
+{
+    d_ptr->pixmapItem->setSourcePixmap(QPixmap::fromImage(image));
+    d_ptr->pixmapItem->setScale(1.0);
+    d_ptr->pixmapItem->setMaskEditingEnabled(true);
+    d_ptr->sourceImage = image;
 }
 
 void GraphicsView::doScale(qreal factor)
@@ -433,6 +877,74 @@ void GraphicsView::doScale(qreal factor)
                                                                    : Qt::FastTransformation);
 }
 
+void GraphicsView::zoomAt(qreal factor, const QPointF &pos)
+{
+    const auto viewPos = pos.toPoint();
+    const auto scenePos = mapToScene(viewPos);
+    const auto anchor = transformationAnchor();
+    setTransformationAnchor(NoAnchor);
+    doScale(factor);
+    setTransformationAnchor(anchor);
+    // 保持滚轮位置下的场景点不动
+    const auto offset = mapFromScene(scenePos) - viewPos;
+    horizontalScrollBar()->setValue(horizontalScrollBar()->value() + offset.x());
+    verticalScrollBar()->setValue(verticalScrollBar()->value() + offset.y());
+}
+
+void GraphicsView::scheduleFrame()
+{
+    if (d_ptr->frameTimer->isActive()) {
+        return;
+    }
+    const auto refreshRate = screen() ? screen()->refreshRate() : 60.0;
+    d_ptr->frameTimer->start(qMax(qRound(1000.0 / qMax(refreshRate, 30.0)), 1));
+    d_ptr->frameClock.start();
+}
+
+void GraphicsView::onFrameTick()
+{
+    const auto elapsed = static_cast<qreal>(qBound<qint64>(1, d_ptr->frameClock.restart(), 100));
+    auto active = false;
+
+    if (d_ptr->pendingZoom != 1.0) {
+        // 每帧应用剩余缩放的一部分，按时间指数逼近目标，和刷新率无关
+        const auto fraction = 1.0 - qExp(-elapsed / ImageViewPrivate::zoomTimeConstant);
+        auto step = qPow(d_ptr->pendingZoom, fraction);
+        if (qAbs(qLn(d_ptr->pendingZoom)) < 0.002) {
+            step = d_ptr->pendingZoom;
+        }
+        d_ptr->pendingZoom /= step;
+        if (qAbs(qLn(d_ptr->pendingZoom)) < 1e-6) {
+            d_ptr->pendingZoom = 1.0;
+        }
+        zoomAt(step, d_ptr->zoomAnchor);
+        active = d_ptr->pendingZoom != 1.0;
+    }
+
+    if (!d_ptr->panning && !d_ptr->panVelocity.isNull()) {
+        d_ptr->pendingPan += d_ptr->panVelocity * (elapsed / 1000.0);
+        d_ptr->panVelocity *= qExp(-elapsed / ImageViewPrivate::momentumTimeConstant);
+        const auto speed = qSqrt(QPointF::dotProduct(d_ptr->panVelocity, d_ptr->panVelocity));
+        if (speed < ImageViewPrivate::minimumMomentum) {
+            d_ptr->panVelocity = QPointF();
+        } else {
+            active = true;
+        }
+    }
+
+    // 滚动条只能移动整数像素，余下的留到下一帧
+    const auto pan = d_ptr->pendingPan.toPoint();
+    if (!pan.isNull()) {
+        horizontalScrollBar()->setValue(horizontalScrollBar()->value() - pan.x());
+        verticalScrollBar()->setValue(verticalScrollBar()->value() - pan.y());
+        d_ptr->pendingPan -= pan;
+    }
+
+    if (!active) {
+        d_ptr->frameTimer->stop();
+    }
+}
+
 void GraphicsView::reset()
 {
     scene()->clear();
@@ -6,6 +6,7 @@
 
 namespace Graphics {
 
+class AnimationPlayer;
 class GraphicsPixmapItem;
 class GRAPHICS_EXPORT GraphicsView : public QGraphicsView
 {
@@ -15,8 +16,17 @@ public:
     explicit GraphicsView(QGraphicsScene *scene, QWidget *parent = nullptr);
     ~GraphicsView() override;
 
+    // The full resolution pixmap. While a reduced resolution preview or a tiled image is
+    // shown, or the file is still loading, the file is decoded and the call blocks until it
+    // is read. Null if the image is too large to decode as a whole.
     [[nodiscard]] auto pixmap() const -> QPixmap;
     auto pixmapItem() -> GraphicsPixmapItem *;
+    // Null unless an animated image is playing, exposes frame timing statistics.
+    [[nodiscard]] auto animationPlayer() const -> AnimationPlayer *;
+
+    // Opt-in OpenGL viewport, pixmaps and tiles are drawn as textures. Stays on the raster
+    // viewport when no OpenGL context can be created; software drivers such as llvmpipe work.
+    [[nodiscard]] auto isHardwareAccelerated() const -> bool;
 
 public slots:
     void createScene(const QString &imageUrlChanged);
@@ -26,6 +36,8 @@ public slots:
     void setViewBackground(bool enable);
     void setViewOutline(bool enable);
     void setViewCrossLine(bool enable);
+    void setViewFrameRate(bool enable);
+    void setHardwareAcceleration(bool enable);
     void zoomIn();
     void zoomOut();
     void resetToOriginalSize();
@@ -40,14 +52,16 @@ signals:
     void imageUrlChanged(const QString &);
 
 private slots:
-    void onMovieFrameChanged(int frameNumber);
+    void onAnimationFrameChanged(const QImage &frame);
 
 protected:
     void drawBackground(QPainter *painter, const QRectF &rect) override;
     void drawForeground(QPainter *painter, const QRectF &rect) override;
 
     void wheelEvent(QWheelEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
     void mouseDoubleClickEvent(QMouseEvent *event) override;
 
     void dragEnterEvent(QDragEnterEvent *event) override;
@@ -61,10 +75,24 @@ private:
     void initScene();
     void createPopMenu();
     auto textRect(const Qt::Corner pos, const QFontMetrics &metrics, const QString &text) -> QRect;
+    void drawTextBox(QPainter *painter, Qt::Corner corner, const QString &text);
     void drawInfo(QPainter *painter);
+    void drawFrameRate(QPainter *painter);
     void drawCrossLine(QPainter *painter);
+    [[nodiscard]] auto infoFont() const -> QFont;
+    auto overlayRegion() -> QRegion;
+    auto pixelInfo(const QPointF &scenePos) -> QString;
     void emitScaleFactor();
+    void showPixmap(const QPixmap &pixmap, const QSize &sourceSize);
+    void showTiledImage(const QString &fileName);
+    [[nodiscard]] auto imageItem() const -> QGraphicsItem *;
+    [[nodiscard]] auto isPreviewing() const -> bool;
+    void loadFullResolutionIfNeeded();
+    void showFullResolution(const QImage &image);
     void doScale(qreal factor);
+    void zoomAt(qreal factor, const QPointF &pos);
+    void scheduleFrame();
+    void onFrameTick();
     void reset();
 
     class ImageViewPrivate;
@@ -0,0 +1,345 @@
+#include "tiledimage.hpp"
+
+#include <QCache>
+#include <QDebug>
+#include <QImageReader>
+#include <QMutex>
+#include <QSet>
+#include <QThreadPool>
+
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <utility>
+
+namespace Graphics {
+
+namespace {
+
+struct TileKey
+{
+    int level = 0;
+    int column = 0;
+    int row = 0;
+};
+
+inline bool operator==(const TileKey &lhs, const TileKey &rhs) noexcept
+{
+    return lhs.level == rhs.level && lhs.column == rhs.column && lhs.row == rhs.row;
+}
+
+inline size_t qHash(const TileKey &key, size_t seed = 0) noexcept
+{
+    return qHashMulti(seed, key.level, key.column, key.row);
+}
+
+// 一个条带解码后的最大字节数
+constexpr qint64 BandBytes = 64 * 1024 * 1024;
+
+// 分块存储的 TIFF 可以只解码裁剪区域内的块
+auto isRandomAccessFormat(const QByteArray &format) -> bool
+{
+    return format == "tif" || format == "tiff";
+}
+
+// 所有 TiledImage 共用，对象析构时不等待正在解码的条带
+auto decodePool() -> QThreadPool *
+{
+    static QThreadPool pool;
+    return &pool;
+}
+
+// 图像的分层布局和解码，布局在构造后不再修改，由解码任务共享。
+// TiledImage 析构后正在解码的任务仍然持有它，结束后丢弃结果
+struct Pyramid
+{
+    [[nodiscard]] auto tileRect(const TileKey &key) const -> QRect
+    {
+        const QRect rect(key.column * TileSize, key.row * TileSize, TileSize, TileSize);
+        return rect.intersected(QRect(QPoint(0, 0), levelSizes.at(key.level)));
+    }
+
+    // 顺序解码的格式（JPEG、PNG 等）裁剪解码时仍要解码裁剪区域上方的所有行，
+    // 所以按横向条带解码，一次切出条带里所有的 tile。条带尽量大但不超过 BandBytes，
+    // 较粗的层通常整层一次解码完。支持随机访问的格式仍逐个 tile 解码
+    [[nodiscard]] auto bandFor(const TileKey &key) const -> TileKey
+    {
+        if (randomAccess) {
+            return key;
+        }
+        const auto rows = bandRows(key.level);
+        return {key.level, 0, key.row / rows * rows};
+    }
+
+    [[nodiscard]] auto bandRows(int level) const -> int
+    {
+        const auto levelSize = levelSizes.at(level);
+        const auto rowBytes = qMax<qint64>(levelSize.width(), 1) * 4 * TileSize;
+        const auto rowCount = (levelSize.height() + TileSize - 1) / TileSize;
+        return static_cast<int>(qBound<qint64>(1, BandBytes / rowBytes, rowCount));
+    }
+
+    [[nodiscard]] auto bandRect(const TileKey &band) const -> QRect
+    {
+        if (randomAccess) {
+            return tileRect(band);
+        }
+        const auto levelSize = levelSizes.at(band.level);
+        const QRect rect(0,
+                         band.row * TileSize,
+                         levelSize.width(),
+                         bandRows(band.level) * TileSize);
+        return rect.intersected(QRect(QPoint(0, 0), levelSize));
+    }
+
+    [[nodiscard]] auto isCanceled(quint64 requested) const -> bool
+    {
+        return generation.load(std::memory_order_relaxed) != requested;
+    }
+
+    // 在线程池中执行。读取本身无法中断，读取前后检查是否已经取消
+    [[nodiscard]] auto decode(const TileKey &band, quint64 requested) const
+        -> QList<std::pair<TileKey, QImage>>
+    {
+        QImageReader reader(fileName);
+        const auto scaledSize = levelSizes.at(band.level);
+        if (scaledSize != size) {
+            reader.setScaledSize(scaledSize);
+        }
+        const auto rect = bandRect(band);
+        if (rect != QRect(QPoint(0, 0), scaledSize)) {
+            reader.setScaledClipRect(rect);
+        }
+        auto image = reader.read();
+        if (isCanceled(requested)) {
+            return {};
+        }
+        if (image.isNull()) {
+            qWarning() << "Failed to decode band" << band.level << band.column << band.row
+                       << reader.errorString();
+            return {};
+        }
+        // 转成绘制最快的格式，避免每次绘制时转换
+        image.convertTo(image.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied
+                                                : QImage::Format_RGB32);
+        if (randomAccess) {
+            return {{band, image}};
+        }
+
+        QList<std::pair<TileKey, QImage>> tiles;
+        const auto first = rect.top() / TileSize;
+        const auto last = rect.bottom() / TileSize;
+        const auto columns = (rect.width() + TileSize - 1) / TileSize;
+        for (int row = first; row <= last; ++row) {
+            for (int column = 0; column < columns; ++column) {
+                const TileKey key{band.level, column, row};
+                tiles.append({key, image.copy(tileRect(key).translated(-rect.topLeft()))});
+            }
+        }
+        return tiles;
+    }
+
+    static constexpr int TileSize = TiledImage::TileSize;
+
+    QString fileName;
+    QSize size;
+    QList<QSize> levelSizes;
+    bool randomAccess = false; // 格式支持只解码裁剪区域
+
+    // 取消时递增，正在解码的任务据此丢弃结果
+    std::atomic<quint64> generation = 0;
+    // 析构时在锁内置位，之后任务不再向已经删除的对象投递结果
+    QMutex mutex;
+    bool detached = false;
+};
+
+} // namespace
+
+class TiledImage::TiledImagePrivate
+{
+public:
+    explicit TiledImagePrivate(TiledImage *q)
+        : q_ptr(q)
+    {
+        cache.setMaxCost(256 * 1024 * 1024);
+    }
+
+    ~TiledImagePrivate()
+    {
+        // 不在 GUI 线程等待正在解码的条带，它们结束后丢弃结果
+        pyramid->generation.fetch_add(1, std::memory_order_relaxed);
+        QMutexLocker locker(&pyramid->mutex);
+        pyramid->detached = true;
+    }
+
+    void initLevels()
+    {
+        auto levelSize = pyramid->size;
+        pyramid->levelSizes.append(levelSize);
+        while (qMax(levelSize.width(), levelSize.height()) > TileSize) {
+            levelSize = QSize((levelSize.width() + 1) / 2, (levelSize.height() + 1) / 2);
+            pyramid->levelSizes.append(levelSize);
+        }
+    }
+
+    [[nodiscard]] auto isValidKey(const TileKey &key) const -> bool
+    {
+        return key.level >= 0 && key.level < pyramid->levelSizes.size()
+               && !pyramid->tileRect(key).isEmpty();
+    }
+
+    void request(const TileKey &key)
+    {
+        const auto band = pyramid->bandFor(key);
+        const auto current = pyramid->generation.load(std::memory_order_relaxed);
+        if (pendings.value(band, current + 1) == current) {
+            return;
+        }
+        pendings.insert(band, current);
+        decodePool()->start([this, pyramid = pyramid, band, current] {
+            if (pyramid->isCanceled(current)) {
+                return; // 已经取消
+            }
+            auto tiles = pyramid->decode(band, current);
+            QMutexLocker locker(&pyramid->mutex);
+            if (pyramid->detached || pyramid->isCanceled(current)) {
+                return;
+            }
+            QMetaObject::invokeMethod(
+                q_ptr,
+                [this, band, tiles = std::move(tiles)] { onBandDecoded(band, tiles); },
+                Qt::QueuedConnection);
+        });
+    }
+
+    void onBandDecoded(const TileKey &band, const QList<std::pair<TileKey, QImage>> &tiles)
+    {
+        pendings.remove(band);
+        if (tiles.isEmpty()) {
+            failedBands.insert(band);
+            return;
+        }
+        for (const auto &[key, image] : tiles) {
+            cache.insert(key, new QImage(image), qMax<qsizetype>(image.sizeInBytes(), 1));
+            emit q_ptr->tileLoaded(key.level, key.column, key.row);
+        }
+    }
+
+    TiledImage *q_ptr;
+
+    const std::shared_ptr<Pyramid> pyramid = std::make_shared<Pyramid>();
+
+    // 以下成员只在主线程访问
+    QCache<TileKey, QImage> cache;
+    QHash<TileKey, quint64> pendings; // 值为请求时的 generation
+    QSet<TileKey> failedBands;
+};
+
+TiledImage::TiledImage(const QString &fileName, QObject *parent)
+    : QObject{parent}
+    , d_ptr{new TiledImagePrivate{this}}
+{
+    d_ptr->pyramid->fileName = fileName;
+    QImageReader reader(fileName);
+    d_ptr->pyramid->size = reader.size();
+    d_ptr->pyramid->randomAccess = isRandomAccessFormat(reader.format());
+    if (!d_ptr->pyramid->size.isValid()) {
+        qWarning() << "Failed to read image size:" << fileName;
+        return;
+    }
+    d_ptr->initLevels();
+    // 最粗的一层只有一个 tile，先加载用作其它层未就绪时的占位
+    d_ptr->request({levelCount() - 1, 0, 0});
+}
+
+TiledImage::~TiledImage() {}
+
+auto TiledImage::canTile(const QImageReader &reader) -> bool
+{
+    return reader.supportsOption(QImageIOHandler::ScaledClipRect)
+           && reader.supportsOption(QImageIOHandler::ScaledSize);
+}
+
+auto TiledImage::isValid() const -> bool
+{
+    return !d_ptr->pyramid->levelSizes.isEmpty();
+}
+
+auto TiledImage::fileName() const -> QString
+{
+    return d_ptr->pyramid->fileName;
+}
+
+auto TiledImage::size() const -> QSize
+{
+    return d_ptr->pyramid->size;
+}
+
+auto TiledImage::levelCount() const -> int
+{
+    return d_ptr->pyramid->levelSizes.size();
+}
+
+auto TiledImage::levelSize(int level) const -> QSize
+{
+    return d_ptr->pyramid->levelSizes.value(level);
+}
+
+auto TiledImage::levelForScale(qreal scale) const -> int
+{
+    if (!isValid() || scale >= 1.0) {
+        return 0;
+    }
+    if (scale <= 0.0) {
+        return levelCount() - 1;
+    }
+    const auto level = static_cast<int>(std::floor(std::log2(1.0 / scale)));
+    return qBound(0, level, levelCount() - 1);
+}
+
+auto TiledImage::tileCount(int level) const -> QSize
+{
+    const auto size = levelSize(level);
+    return QSize((size.width() + TileSize - 1) / TileSize,
+                 (size.height() + TileSize - 1) / TileSize);
+}
+
+auto TiledImage::tileRect(int level, int column, int row) const -> QRect
+{
+    if (level < 0 || level >= levelCount()) {
+        return {};
+    }
+    return d_ptr->pyramid->tileRect({level, column, row});
+}
+
+auto TiledImage::tile(int level, int column, int row, QImage &image, bool request) -> bool
+{
+    const TileKey key{level, column, row};
+    if (const auto *cached = d_ptr->cache.object(key)) {
+        image = *cached;
+        return true;
+    }
+    if (request && d_ptr->isValidKey(key)
+        && !d_ptr->failedBands.contains(d_ptr->pyramid->bandFor(key))) {
+        d_ptr->request(key);
+    }
+    return false;
+}
+
+void TiledImage::cancelPending()
+{
+    d_ptr->pyramid->generation.fetch_add(1, std::memory_order_relaxed);
+    d_ptr->pendings.clear();
+}
+
+void TiledImage::setCacheBytes(qint64 bytes)
+{
+    d_ptr->cache.setMaxCost(qMax<qint64>(bytes, 0));
+}
+
+auto TiledImage::cacheBytes() const -> qint64
+{
+    return d_ptr->cache.maxCost();
+}
+
+} // namespace Graphics
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "graphics_global.h"
+
+#include <QImage>
+#include <QObject>
+
+class QImageReader;
+
+namespace Graphics {
+
+// Multi-resolution view of an image file split into TileSize square tiles.
+// Level 0 is the full resolution and every following level halves the previous one
+// until the whole image fits into a single tile. Tiles are decoded lazily on a
+// shared thread pool, only the decoded tiles are kept in memory. Sequential formats
+// such as JPEG are decoded in horizontal bands that are sliced into tiles, so each
+// scanline of a level is decoded once per band instead of once per tile.
+class GRAPHICS_EXPORT TiledImage : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr int TileSize = 256;
+
+    explicit TiledImage(const QString &fileName, QObject *parent = nullptr);
+    ~TiledImage() override;
+
+    // Region decoding needs support from the image format plugin, e.g. JPEG.
+    [[nodiscard]] static auto canTile(const QImageReader &reader) -> bool;
+
+    [[nodiscard]] auto isValid() const -> bool;
+    [[nodiscard]] auto fileName() const -> QString;
+    [[nodiscard]] auto size() const -> QSize;
+
+    [[nodiscard]] auto levelCount() const -> int;
+    [[nodiscard]] auto levelSize(int level) const -> QSize;
+    // The coarsest level that still has at least one pixel per device pixel,
+    // scale being device pixels per full resolution pixel.
+    [[nodiscard]] auto levelForScale(qreal scale) const -> int;
+    [[nodiscard]] auto tileCount(int level) const -> QSize;
+    // In pixels of the level.
+    [[nodiscard]] auto tileRect(int level, int column, int row) const -> QRect;
+
+    // Returns a cached tile. Otherwise schedules its decode when request is true,
+    // tileLoaded is emitted once it is available.
+    auto tile(int level, int column, int row, QImage &image, bool request = true) -> bool;
+    // Drops the queued decodes. Decodes that already started finish in the background and
+    // discard their result; destroying the image does not wait for them either.
+    void cancelPending();
+
+    void setCacheBytes(qint64 bytes);
+    [[nodiscard]] auto cacheBytes() const -> qint64;
+
+signals:
+    void tileLoaded(int level, int column, int row);
+
+private:
+    class TiledImagePrivate;
+    QScopedPointer<TiledImagePrivate> d_ptr;
+};
+
+} // namespace Graphics
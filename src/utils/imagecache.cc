@@ -1,66 +1,329 @@
 #include "imagecache.hpp"
-#include "threadutils.h"
 #include "utils.hpp"
 
-#include <QCache>
+#include <QHash>
 #include <QImage>
+#include <QImageReader>
+#include <QMutex>
+
+#include <array>
+#include <atomic>
+#include <list>
 
 namespace Utils {
 
-static QImage syncLoadImage(const QString &absoluteFilePath)
+static quint64 hashPath(QStringView path)
 {
-    auto func = [absoluteFilePath]() -> QImage {
-        return absoluteFilePath.isEmpty() ? QImage{} : QImage{absoluteFilePath};
-    };
-    return asynchronous<QImage>(func);
+    // FNV-1a 64，结果与进程无关，可以用作磁盘缓存的文件名
+    quint64 hash = 14695981039346656037ULL;
+    for (const auto ch : path) {
+        hash ^= ch.unicode();
+        hash *= 1099511628211ULL;
+    }
+    return hash;
 }
 
-QString getCacheKey(const QFileInfo &fileInfo)
+auto CacheKey::toString() const -> QString
+{
+    return QString("%1%2%3")
+        .arg(pathHash, 16, 16, QLatin1Char('0'))
+        .arg(static_cast<quint64>(lastModified), 16, 16, QLatin1Char('0'))
+        .arg(static_cast<quint64>(size), 16, 16, QLatin1Char('0'));
+}
+
+auto getCacheKey(const QFileInfo &fileInfo) -> CacheKey
 {
     if (!fileInfo.exists()) {
         return {};
     }
-    auto temp = QString("%1|%2|%3")
-                    .arg(fileInfo.absoluteFilePath(),
-                         QString::number(fileInfo.lastModified().toSecsSinceEpoch()),
-                         QString::number(fileInfo.size()));
-    return QCryptographicHash::hash(temp.toLocal8Bit(), QCryptographicHash::Md5).toHex();
+    return {hashPath(fileInfo.absoluteFilePath()),
+            fileInfo.lastModified(QTimeZone::UTC).toMSecsSinceEpoch(),
+            fileInfo.size()};
+}
+
+namespace {
+
+struct ImageKey
+{
+    CacheKey file;
+    int maxDimension = 0; // 0 表示原始分辨率
+};
+
+inline bool operator==(const ImageKey &lhs, const ImageKey &rhs) noexcept
+{
+    return lhs.file == rhs.file && lhs.maxDimension == rhs.maxDimension;
 }
 
+inline size_t qHash(const ImageKey &key, size_t seed = 0) noexcept
+{
+    return qHashMulti(seed, key.file, key.maxDimension);
+}
+
+} // namespace
+
 class ImageCache::ImageCachePrivate
 {
 public:
+    struct Counters
+    {
+        std::atomic<qint64> hits = 0;
+        std::atomic<qint64> misses = 0;
+        std::atomic<qint64> evictions = 0;
+        std::atomic<qint64> evictedBytes = 0;
+    };
+
+    // 每个分片独立加锁并维护自己的 LRU 链表，不同分片之间互不阻塞。
+    // 预算是全局的：所有分片共用一个总字节数，淘汰时在各分片之间按访问顺序进行
+    class Shard
+    {
+    public:
+        void insert(const ImageKey &key, const QImage &image, qint64 cost, quint64 tick)
+        {
+            QMutexLocker locker(&mutex);
+            auto it = index.find(key);
+            if (it != index.end()) {
+                release(it.value()->cost);
+                lru.erase(it.value());
+                index.erase(it);
+            }
+            lru.push_front({key, image, cost, tick});
+            index.insert(key, lru.begin());
+            totalCost += cost;
+            sharedCost->fetch_add(cost, std::memory_order_relaxed);
+        }
+
+        bool find(const ImageKey &key, QImage &image, quint64 tick)
+        {
+            QMutexLocker locker(&mutex);
+            auto it = index.constFind(key);
+            if (it == index.cend()) {
+                return false;
+            }
+            // 命中后移动到链表头部
+            lru.splice(lru.begin(), lru, it.value());
+            it.value()->tick = tick;
+            image = it.value()->image;
+            return true;
+        }
+
+        void clear()
+        {
+            QMutexLocker locker(&mutex);
+            release(totalCost);
+            lru.clear();
+            index.clear();
+            totalCost = 0;
+        }
+
+        void collect(Statistics &statistics)
+        {
+            QMutexLocker locker(&mutex);
+            statistics.count += lru.size();
+            statistics.totalBytes += totalCost;
+        }
+
+        // 最久未使用的条目的访问序号，分片为空时返回 false
+        bool oldestTick(quint64 &tick)
+        {
+            QMutexLocker locker(&mutex);
+            if (lru.empty()) {
+                return false;
+            }
+            tick = lru.back().tick;
+            return true;
+        }
+
+        void evictOldest()
+        {
+            QMutexLocker locker(&mutex);
+            if (lru.empty()) {
+                return;
+            }
+            const auto &entry = lru.back();
+            totalCost -= entry.cost;
+            release(entry.cost);
+            index.remove(entry.key);
+            counters->evictedBytes.fetch_add(entry.cost, std::memory_order_relaxed);
+            lru.pop_back();
+            counters->evictions.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        Counters *counters = nullptr;
+        std::atomic<qint64> *sharedCost = nullptr;
+
+    private:
+        struct Entry
+        {
+            ImageKey key;
+            QImage image;
+            qint64 cost = 0;
+            quint64 tick = 0; // 最近一次访问的序号
+        };
+        using EntryList = std::list<Entry>;
+
+        void release(qint64 cost) { sharedCost->fetch_sub(cost, std::memory_order_relaxed); }
+
+        QMutex mutex;
+        EntryList lru;
+        QHash<ImageKey, EntryList::iterator> index;
+        qint64 totalCost = 0;
+    };
+
     explicit ImageCachePrivate(ImageCache *q)
         : q_ptr(q)
     {
-        imageCache.setMaxCost(1024 * 1024);
+        for (auto &shard : shards) {
+            shard.counters = &counters;
+            shard.sharedCost = &totalCost;
+        }
+        // 默认 1 GiB，内存较小的机器上不超过物理内存的四分之一
+        qint64 bytes = 1024LL * 1024 * 1024;
+        if (const auto memory = physicalMemory(); memory > 0) {
+            bytes = qMin(bytes, memory / 4);
+        }
+        setMaxBytes(bytes);
     }
 
-    void insert(const QString &key, const QImage &image)
+    void setMaxBytes(qint64 bytes)
     {
-        Q_ASSERT(Utils::isMainThread());
-        imageCache.insert(key, new QImage(image), qMax(qCeil(image.sizeInBytes() / 1024.0), 1));
+        maxBytes = qMax<qint64>(bytes, 0);
+        updateLimits();
     }
 
-    bool find(const QString &key, QImage &image)
+    void updateLimits()
     {
-        Q_ASSERT(Utils::isMainThread());
-        auto *imagePtr = imageCache.object(key);
-        if (!imagePtr) {
+        highCost.store(static_cast<qint64>(maxBytes * highWatermark), std::memory_order_relaxed);
+        lowCost.store(static_cast<qint64>(maxBytes * lowWatermark), std::memory_order_relaxed);
+        if (totalCost.load(std::memory_order_relaxed) > highCost.load(std::memory_order_relaxed)) {
+            evictToCost(lowCost.load(std::memory_order_relaxed));
+        }
+    }
+
+    // 每次从所有分片中最久未使用的条目淘汰，近似全局 LRU
+    void evictToCost(qint64 cost)
+    {
+        QMutexLocker locker(&evictMutex);
+        while (totalCost.load(std::memory_order_relaxed) > cost) {
+            Shard *oldest = nullptr;
+            quint64 oldestTick = 0;
+            for (auto &shard : shards) {
+                quint64 tick = 0;
+                if (shard.oldestTick(tick) && (!oldest || tick < oldestTick)) {
+                    oldest = &shard;
+                    oldestTick = tick;
+                }
+            }
+            if (!oldest) {
+                return;
+            }
+            oldest->evictOldest();
+        }
+    }
+
+    auto shard(const ImageKey &key) -> Shard & { return shards[qHash(key) % shardCount]; }
+
+    void insert(const ImageKey &key, const QImage &image)
+    {
+        if (!key.file.isValid() || image.isNull()) {
+            return;
+        }
+        const auto cost = qMax<qint64>(image.sizeInBytes(), 1);
+        const auto high = highCost.load(std::memory_order_relaxed);
+        // 单张图片只要不超过整个预算就可以缓存
+        if (cost > high) {
+            return;
+        }
+        shard(key).insert(key, image, cost, nextTick());
+        // 超过高水位后一次性淘汰到低水位，避免每次插入都触发淘汰
+        if (totalCost.load(std::memory_order_relaxed) > high) {
+            evictToCost(qMax(lowCost.load(std::memory_order_relaxed), cost));
+        }
+    }
+
+    auto nextTick() -> quint64 { return accessTick.fetch_add(1, std::memory_order_relaxed); }
+
+    bool find(const ImageKey &key, QImage &image)
+    {
+        if (!key.file.isValid()) {
             return false;
         }
-        image = *imagePtr;
-        return true;
+        // 已经缓存了原图时直接使用原图
+        const auto tick = nextTick();
+        if (shard(key).find(key, image, tick)
+            || (key.maxDimension > 0 && shard({key.file, 0}).find({key.file, 0}, image, tick))) {
+            counters.hits.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        counters.misses.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // 同一个 key 的并发请求共用一次解码
+    auto load(const ImageKey &key, const QString &absoluteFilePath) -> QFuture<QImage>
+    {
+        if (!key.file.isValid()) {
+            return QtFuture::makeReadyValueFuture(QImage{});
+        }
+
+        QMutexLocker locker(&pendingMutex);
+        auto it = pendings.constFind(key);
+        if (it != pendings.cend()) {
+            return it.value();
+        }
+        auto future = QtConcurrent::run(&loadPool, [this, key, absoluteFilePath]() -> QImage {
+            QImageReader reader(absoluteFilePath);
+            auto cacheKey = key;
+            if (key.maxDimension > 0) {
+                // JPEG 等格式的插件会直接按缩放后的尺寸解码（DCT scaling）
+                const auto size = reader.size();
+                if (size.isValid() && qMax(size.width(), size.height()) > key.maxDimension) {
+                    reader.setScaledSize(
+                        size.scaled(key.maxDimension, key.maxDimension, Qt::KeepAspectRatio));
+                } else {
+                    cacheKey.maxDimension = 0;
+                }
+            }
+            auto image = reader.read();
+            insert(cacheKey, image);
+            QMutexLocker locker(&pendingMutex);
+            pendings.remove(key);
+            return image;
+        });
+        pendings.insert(key, future);
+        return future;
     }
 
     ImageCache *q_ptr;
 
-    QCache<QString, QImage> imageCache;
+    static constexpr int shardCount = 16;
+    std::array<Shard, shardCount> shards;
+
+    Counters counters;
+    std::atomic<qint64> totalCost = 0;
+    std::atomic<quint64> accessTick = 0;
+    std::atomic<qint64> highCost = 0;
+    std::atomic<qint64> lowCost = 0;
+    QMutex evictMutex;
+
+    QMutex limitMutex;
+    qint64 maxBytes = 0;
+    double highWatermark = 1.0;
+    double lowWatermark = 0.9;
+
+    QMutex pendingMutex;
+    QHash<ImageKey, QFuture<QImage>> pendings;
+    // 放在最后，析构时先等待解码任务结束
+    QThreadPool loadPool;
 };
 
 void ImageCache::insert(const QString &absoluteFilePath, const QImage &image)
 {
-    d_ptr->insert(getCacheKey(QFileInfo(absoluteFilePath)), image);
+    d_ptr->insert({getCacheKey(QFileInfo(absoluteFilePath)), 0}, image);
+}
+
+void ImageCache::insert(const CacheKey &key, const QImage &image)
+{
+    d_ptr->insert({key, 0}, image);
 }
 
 bool ImageCache::find(const QString &absoluteFilePath, QImage &image)
@@ -69,18 +332,90 @@ bool ImageCache::find(const QString &absoluteFilePath, QImage &image)
         return false;
     }
 
-    auto key = getCacheKey(QFileInfo(absoluteFilePath));
-    auto ret = d_ptr->find(key, image);
-    if (!ret) {
-        image = syncLoadImage(absoluteFilePath);
-        if (image.isNull()) {
-            return false;
-        }
-        d_ptr->insert(key, image);
+    const ImageKey key{getCacheKey(QFileInfo(absoluteFilePath)), 0};
+    if (d_ptr->find(key, image)) {
+        return true;
+    }
+    // 真正阻塞调用线程，不运行嵌套的事件循环；解码在独立的线程池中进行
+    image = d_ptr->load(key, absoluteFilePath).result();
+    return !image.isNull();
+}
+
+auto ImageCache::findAsync(const QString &absoluteFilePath, int maxDimension) -> QFuture<QImage>
+{
+    if (absoluteFilePath.isEmpty()) {
+        return QtFuture::makeReadyValueFuture(QImage{});
+    }
+
+    // 按 2 的幂取整，相近的请求可以共用同一份缓存
+    if (maxDimension > 0) {
+        maxDimension = qMin<quint32>(qNextPowerOfTwo(quint32(maxDimension - 1)), 1U << 30);
     }
+    const ImageKey key{getCacheKey(QFileInfo(absoluteFilePath)), qMax(maxDimension, 0)};
+    QImage image;
+    if (d_ptr->find(key, image)) {
+        return QtFuture::makeReadyValueFuture(image);
+    }
+    return d_ptr->load(key, absoluteFilePath);
+}
+
+auto ImageCache::statistics() const -> Statistics
+{
+    Statistics statistics;
+    statistics.hits = d_ptr->counters.hits.load(std::memory_order_relaxed);
+    statistics.misses = d_ptr->counters.misses.load(std::memory_order_relaxed);
+    statistics.evictions = d_ptr->counters.evictions.load(std::memory_order_relaxed);
+    statistics.evictedBytes = d_ptr->counters.evictedBytes.load(std::memory_order_relaxed);
+    statistics.maxBytes = maxBytes();
+    for (auto &shard : d_ptr->shards) {
+        shard.collect(statistics);
+    }
+    return statistics;
+}
+
+void ImageCache::setMaxBytes(qint64 bytes)
+{
+    QMutexLocker locker(&d_ptr->limitMutex);
+    d_ptr->setMaxBytes(bytes);
+}
+
+auto ImageCache::maxBytes() const -> qint64
+{
+    QMutexLocker locker(&d_ptr->limitMutex);
+    return d_ptr->maxBytes;
+}
+
+bool ImageCache::setMaxMemoryPercent(double percent)
+{
+    const auto memory = physicalMemory();
+    if (memory <= 0) {
+        qWarning() << "Failed to query physical memory size";
+        return false;
+    }
+    setMaxBytes(static_cast<qint64>(memory * qBound(0.0, percent, 100.0) / 100.0));
     return true;
 }
 
+void ImageCache::setWatermarks(double high, double low)
+{
+    QMutexLocker locker(&d_ptr->limitMutex);
+    d_ptr->highWatermark = qBound(0.0, high, 1.0);
+    d_ptr->lowWatermark = qBound(0.0, low, d_ptr->highWatermark);
+    d_ptr->updateLimits();
+}
+
+void ImageCache::trim(qint64 targetBytes)
+{
+    d_ptr->evictToCost(qMax<qint64>(targetBytes, 0));
+}
+
+void ImageCache::clear()
+{
+    for (auto &shard : d_ptr->shards) {
+        shard.clear();
+    }
+}
+
 ImageCache::ImageCache(QObject *parent)
     : QObject{parent}
     , d_ptr{new ImageCachePrivate{this}}
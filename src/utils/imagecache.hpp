@@ -3,21 +3,95 @@
 #include "singleton.hpp"
 #include "utils_global.h"
 
+#include <QFuture>
+#include <QHashFunctions>
+#include <QImage>
 #include <QObject>
 
 class QFileInfo;
 
 namespace Utils {
 
-UTILS_EXPORT QString getCacheKey(const QFileInfo &fileInfo);
+struct UTILS_EXPORT CacheKey
+{
+    [[nodiscard]] auto isValid() const -> bool { return size >= 0; }
+    // Stable across runs, suitable as a file name.
+    [[nodiscard]] auto toString() const -> QString;
+
+    quint64 pathHash = 0;
+    qint64 lastModified = 0; // msecs since epoch, UTC
+    qint64 size = -1;
+};
+
+inline bool operator==(const CacheKey &lhs, const CacheKey &rhs) noexcept
+{
+    return lhs.pathHash == rhs.pathHash && lhs.lastModified == rhs.lastModified
+           && lhs.size == rhs.size;
+}
+
+inline size_t qHash(const CacheKey &key, size_t seed = 0) noexcept
+{
+    return qHashMulti(seed, key.pathHash, key.lastModified, key.size);
+}
+
+// Uses the stat data already cached in fileInfo, no extra file system access.
+UTILS_EXPORT auto getCacheKey(const QFileInfo &fileInfo) -> CacheKey;
 
 class UTILS_EXPORT ImageCache : public QObject
 {
     Q_OBJECT
 public:
+    struct Statistics
+    {
+        qint64 hits = 0;
+        qint64 misses = 0;
+        qint64 evictions = 0;
+        qint64 evictedBytes = 0;
+        qint64 count = 0;
+        qint64 totalBytes = 0;
+        qint64 maxBytes = 0;
+    };
+
+    // Thread-safe, may be called from any thread.
     void insert(const QString &absoluteFilePath, const QImage &image);
+    void insert(const CacheKey &key, const QImage &image);
+    // Blocks the calling thread until the image is decoded, prefer findAsync() on the GUI thread.
     bool find(const QString &absoluteFilePath, QImage &image);
 
+    // Returns immediately; concurrent requests for the same file share one decode.
+    // A positive maxDimension decodes at reduced resolution so that the longer side
+    // is at most maxDimension rounded up to a power of two, an already cached full
+    // resolution image is returned instead when there is one.
+    auto findAsync(const QString &absoluteFilePath, int maxDimension = 0) -> QFuture<QImage>;
+    // The function is invoked in the thread of context with the decoded image,
+    // a null image means the file could not be read.
+    template<typename Function>
+    void findAsync(const QString &absoluteFilePath, QObject *context, Function &&function)
+    {
+        findAsync(absoluteFilePath).then(context, std::forward<Function>(function));
+    }
+    template<typename Function>
+    void findAsync(const QString &absoluteFilePath,
+                   int maxDimension,
+                   QObject *context,
+                   Function &&function)
+    {
+        findAsync(absoluteFilePath, maxDimension).then(context, std::forward<Function>(function));
+    }
+
+    [[nodiscard]] auto statistics() const -> Statistics;
+
+    // Defaults to 1 GiB, or a quarter of the physical memory when that is smaller.
+    void setMaxBytes(qint64 bytes);
+    [[nodiscard]] auto maxBytes() const -> qint64;
+    bool setMaxMemoryPercent(double percent);
+    // Once the cache grows beyond high * maxBytes it evicts down to low * maxBytes.
+    void setWatermarks(double high, double low);
+    // Evicts least recently used images until at most targetBytes remain,
+    // intended to be called under memory pressure.
+    void trim(qint64 targetBytes);
+    void clear();
+
 private:
     explicit ImageCache(QObject *parent = nullptr);
     ~ImageCache() override;
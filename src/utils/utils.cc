@@ -9,6 +9,8 @@
 #ifdef Q_OS_WIN
 #include <windows.h>
 #include <tlhelp32.h>
+#else
+#include <unistd.h>
 #endif
 // clang-format on
 
@@ -297,6 +299,25 @@ auto configLocation() -> QString
     return path;
 }
 
+auto physicalMemory() -> qint64
+{
+#if defined(Q_OS_WIN)
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    if (!GlobalMemoryStatusEx(&status)) {
+        return -1;
+    }
+    return status.ullTotalPhys;
+#else
+    const auto pages = sysconf(_SC_PHYS_PAGES);
+    const auto pageSize = sysconf(_SC_PAGESIZE);
+    if (pages <= 0 || pageSize <= 0) {
+        return -1;
+    }
+    return static_cast<qint64>(pages) * pageSize;
+#endif
+}
+
 auto getPidFromProcessName(const QString &processName) -> qint64
 {
 #if defined(Q_OS_WIN)